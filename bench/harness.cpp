@@ -0,0 +1,98 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "harness.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace dci::mm::bench
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Harness::Harness(int argc, char* argv[])
+    {
+        for(int idx{1}; idx<argc; ++idx)
+        {
+            std::string arg = argv[idx];
+
+            if("--filter" == arg && idx+1 < argc)
+            {
+                _filter = argv[++idx];
+            }
+            else if("--json" == arg && idx+1 < argc)
+            {
+                _jsonPath = argv[++idx];
+            }
+            else if("--min-time" == arg && idx+1 < argc)
+            {
+                _minSeconds = std::atof(argv[++idx]);
+            }
+            else
+            {
+                std::fprintf(stderr, "usage: %s [--filter substring] [--json file] [--min-time seconds]\n", argv[0]);
+                std::exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void Harness::run(const std::string& name, const Body& body)
+    {
+        if(!_filter.empty() && std::string::npos == name.find(_filter))
+        {
+            return;
+        }
+
+        using Clock = std::chrono::steady_clock;
+
+        //прогрев
+        body();
+
+        Result result{name};
+        Clock::time_point start = Clock::now();
+        do
+        {
+            result._operations += body();
+            result._seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+        while(result._seconds < _minSeconds);
+
+        std::printf("%-48s %14.2f ns/op %14zu ops\n", result._name.c_str(), result.nsPerOperation(), result._operations);
+        std::fflush(stdout);
+
+        _results.push_back(std::move(result));
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    int Harness::finish()
+    {
+        if(_jsonPath.empty())
+        {
+            return EXIT_SUCCESS;
+        }
+
+        std::FILE* f = std::fopen(_jsonPath.c_str(), "w");
+        if(!f)
+        {
+            std::perror("fopen");
+            return EXIT_FAILURE;
+        }
+
+        std::fprintf(f, "{\n    \"benchmarks\": [\n");
+        for(std::size_t idx{}; idx<_results.size(); ++idx)
+        {
+            const Result& r = _results[idx];
+            std::fprintf(f, "        {\"name\": \"%s\", \"operations\": %zu, \"seconds\": %.9f, \"ns_per_op\": %.3f}%s\n",
+                         r._name.c_str(), r._operations, r._seconds, r.nsPerOperation(),
+                         idx+1 < _results.size() ? "," : "");
+        }
+        std::fprintf(f, "    ]\n}\n");
+        std::fclose(f);
+
+        return EXIT_SUCCESS;
+    }
+}
@@ -0,0 +1,63 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace dci::mm::bench
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    struct Result
+    {
+        std::string _name;
+        std::size_t _operations {};
+        double      _seconds {};
+
+        double nsPerOperation() const
+        {
+            return _operations ? _seconds * 1e9 / static_cast<double>(_operations) : 0;
+        }
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // тело выполняет пачку операций и возвращает их количество
+    using Body = std::function<std::size_t()>;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    template <class T>
+    inline void doNotOptimize(const T& value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    class Harness
+    {
+    public:
+        Harness(int argc, char* argv[]);
+
+        void run(const std::string& name, const Body& body);
+        int finish();
+
+    private:
+        std::string         _filter;
+        std::string         _jsonPath;
+        double              _minSeconds {0.2};
+        std::vector<Result> _results;
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void heap(Harness& harness);
+    void stack(Harness& harness);
+    void idAllocator(Harness& harness);
+}
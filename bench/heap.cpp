@@ -0,0 +1,83 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "harness.hpp"
+#include <dci/mm/heap.hpp>
+
+#include <cstdlib>
+#include <utility>
+
+namespace dci::mm::bench
+{
+    namespace
+    {
+        constexpr std::size_t _batch = 1024;
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        template <std::size_t size>
+        void oneSize(Harness& harness)
+        {
+            harness.run("heap/sizeClass/" + std::to_string(size), []
+            {
+                void* ptrs[_batch];
+                for(void*& ptr : ptrs)
+                {
+                    ptr = mm::heap::alloc<size>();
+                    doNotOptimize(ptr);
+                }
+                for(void* ptr : ptrs)
+                {
+                    mm::heap::free<size>(ptr);
+                }
+                return _batch;
+            });
+
+            harness.run("heap/runtime/" + std::to_string(size), []
+            {
+                void* ptrs[_batch];
+                for(void*& ptr : ptrs)
+                {
+                    ptr = mm::heap::alloc(size);
+                    doNotOptimize(ptr);
+                }
+                for(void* ptr : ptrs)
+                {
+                    mm::heap::free(ptr);
+                }
+                return _batch;
+            });
+
+            //системный malloc, для jemalloc/tcmalloc запускать с LD_PRELOAD
+            harness.run("malloc/" + std::to_string(size), []
+            {
+                void* ptrs[_batch];
+                for(void*& ptr : ptrs)
+                {
+                    ptr = std::malloc(size);
+                    doNotOptimize(ptr);
+                }
+                for(void* ptr : ptrs)
+                {
+                    std::free(ptr);
+                }
+                return _batch;
+            });
+        }
+
+        template <std::size_t... sizes>
+        void allSizes(Harness& harness, std::index_sequence<sizes...>)
+        {
+            (oneSize<std::size_t{8} << sizes>(harness), ...);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void heap(Harness& harness)
+    {
+        allSizes(harness, std::make_index_sequence<10>{});//8 .. 4096
+    }
+}
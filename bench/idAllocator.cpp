@@ -0,0 +1,71 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "harness.hpp"
+#include <dci/mm/idAllocator.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+
+namespace dci::mm::bench
+{
+    namespace
+    {
+        constexpr std::size_t _batch = 1024;
+        constexpr std::size_t _volume = 1024*1024;
+
+        using Ids = IdAllocator<_volume, idAllocator::Storage::vm>;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void idAllocator(Harness& harness)
+    {
+        for(std::size_t fillPercent : {0, 50, 90, 99, 100})
+        {
+            std::unique_ptr<Ids> ids = std::make_unique<Ids>();
+
+            //заполнить целиком и освободить случайную часть, чтобы дыры были разбросаны
+            std::vector<idAllocator::Id> all(_volume);
+            for(idAllocator::Id& id : all)
+            {
+                id = ids->allocate();
+            }
+            std::shuffle(all.begin(), all.end(), std::mt19937_64{42});
+            all.resize(_volume - _volume * fillPercent / 100);
+            for(idAllocator::Id id : all)
+            {
+                ids->deallocate(id);
+            }
+
+            harness.run("idAllocator/allocate-deallocate/fill" + std::to_string(fillPercent), [&]
+            {
+                for(std::size_t idx{}; idx<_batch; ++idx)
+                {
+                    idAllocator::Id id = ids->allocate();
+                    doNotOptimize(id);
+                    if(Ids::_badId != id)
+                    {
+                        ids->deallocate(id);
+                    }
+                }
+                return _batch;
+            });
+
+            harness.run("idAllocator/iterate/fill" + std::to_string(fillPercent), [&]
+            {
+                std::size_t amount{};
+                for(idAllocator::Id id : *ids)
+                {
+                    doNotOptimize(id);
+                    ++amount;
+                }
+                return amount ? amount : std::size_t{1};
+            });
+        }
+    }
+}
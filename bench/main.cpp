@@ -0,0 +1,19 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "harness.hpp"
+
+int main(int argc, char* argv[])
+{
+    dci::mm::bench::Harness harness{argc, argv};
+
+    dci::mm::bench::heap(harness);
+    dci::mm::bench::stack(harness);
+    dci::mm::bench::idAllocator(harness);
+
+    return harness.finish();
+}
@@ -0,0 +1,124 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "harness.hpp"
+#include <dci/mm/stack.hpp>
+
+#include <vector>
+
+#if __has_include(<ucontext.h>)
+#   include <ucontext.h>
+#   define DCI_MM_BENCH_UCONTEXT 1
+#endif
+
+namespace dci::mm::bench
+{
+    namespace
+    {
+        constexpr std::size_t _batch = 256;
+        constexpr std::size_t _pageSize = 4096;
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::size_t createDestroy(const mm::stack::Options& options)
+        {
+            std::vector<Stack> stacks(_batch);
+            for(Stack& stack : stacks)
+            {
+                stack.initialize(options);
+            }
+            return _batch;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        // касание каждой страницы сверху вниз, рост через обработчик обращений
+        std::size_t growth(const mm::stack::Options& options)
+        {
+            Stack stack;
+            stack.initialize(options);
+
+            std::size_t pages{};
+            if(stack.growsDown())
+            {
+                for(char* page = stack.end() - _pageSize; page >= stack.begin(); page -= _pageSize, ++pages)
+                {
+                    *static_cast<volatile char *>(page) = 0;
+                }
+            }
+            else
+            {
+                for(char* page = stack.begin(); page < stack.end(); page += _pageSize, ++pages)
+                {
+                    *static_cast<volatile char *>(page) = 0;
+                }
+            }
+
+            return pages;
+        }
+
+#ifdef DCI_MM_BENCH_UCONTEXT
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        ucontext_t  g_mainContext;
+        ucontext_t  g_stackContext;
+        Stack*      g_stack;
+        std::size_t g_depthPages;
+
+        void touchDeep(std::size_t pages)
+        {
+            volatile char area[_pageSize];
+            area[0] = 0;
+            if(pages > 1)
+            {
+                touchDeep(pages-1);
+            }
+            area[_pageSize-1] = 0;
+            doNotOptimize(area[0]);
+        }
+
+        void growCompactBody()
+        {
+            for(std::size_t idx{}; idx<_batch; ++idx)
+            {
+                touchDeep(g_depthPages);
+                g_stack->compact();
+            }
+        }
+
+        std::size_t growCompact(std::size_t depthPages)
+        {
+            Stack stack;
+            stack.initialize();
+
+            g_stack = &stack;
+            g_depthPages = depthPages;
+
+            getcontext(&g_stackContext);
+            g_stackContext.uc_stack.ss_sp = stack.begin();
+            g_stackContext.uc_stack.ss_size = stack.size();
+            g_stackContext.uc_link = &g_mainContext;
+            makecontext(&g_stackContext, &growCompactBody, 0);
+            swapcontext(&g_mainContext, &g_stackContext);
+
+            return _batch;
+        }
+#endif
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void stack(Harness& harness)
+    {
+        harness.run("stack/create-destroy", []{return createDestroy({});});
+        harness.run("stack/create-destroy/precommit8", []{return createDestroy({8, 1});});
+
+        harness.run("stack/growth/per-page", []{return growth({});});
+        harness.run("stack/growth/per-page/grow4", []{return growth({0, 4});});
+
+#ifdef DCI_MM_BENCH_UCONTEXT
+        harness.run("stack/grow-compact/4pages", []{return growCompact(4);});
+        harness.run("stack/grow-compact/16pages", []{return growCompact(16);});
+#endif
+    }
+}
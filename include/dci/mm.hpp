@@ -11,6 +11,14 @@
 #include "mm/heap/allocable.hpp"
 
 #include "mm/stack.hpp"
+#include "mm/stackSpace.hpp"
+#include "mm/stack/image.hpp"
+#include "mm/context.hpp"
+
+#include "mm/idAllocator.hpp"
+
+#include "mm/stats.hpp"
+#include "mm/reclaim.hpp"
 
 namespace dci::mm
 {
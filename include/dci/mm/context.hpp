@@ -0,0 +1,54 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+#include <cstddef>
+#include "api.hpp"
+
+namespace dci::mm
+{
+    class Stack;
+
+    ////////////////////////////////////////////////////////////////
+    /*
+     * переключение исполнения между стеками: сохраняются только callee-saved регистры и управляющие слова fpu,
+     * без системных вызовов (в отличие от ucontext). пустой Context принимает в себя текущий поток исполнения
+     * при первом switchTo из него
+     */
+    class API_DCI_MM Context
+    {
+    public:
+        // не должна возвращаться, завершается переключением в другой контекст
+        using Entry = void (*)(void* arg);
+
+        Context() = default;
+        Context(const Context& from) = delete;
+        Context(Context&& from);
+        ~Context();
+
+        Context& operator=(const Context& from) = delete;
+        Context& operator=(Context&& from);
+
+        // стек должен жить дольше контекста
+        void initialize(Stack& stack, Entry entry, void* arg);
+
+        // сохранить текущее исполнение в this и продолжить to
+        void switchTo(Context& to);
+
+        Stack* stack() const;
+
+        // сохраненная вершина стека пока приостановлен, nullptr пока исполняется
+        void* suspendedSp() const;
+
+        // отдать системе страницы стека ниже сохраненной вершины
+        void compact();
+
+    private:
+        Stack*  _stack {};
+        void*   _sp {};
+    };
+}
@@ -7,6 +7,7 @@
 
 #pragma once
 #include <cstddef>
+#include <string>
 #include "api.hpp"
 
 #include <dci/himpl.hpp>
@@ -19,6 +20,47 @@ namespace dci::mm::heap
     template <std::size_t size> void* alloc();
     template <std::size_t size> void free(void* ptr);
 
+    ////////////////////////////////////////////////////////////////
+    // выборочное профилирование живых объектов, в среднем одна выборка на sampleInterval байт
+    namespace profile
+    {
+        API_DCI_MM void start(std::size_t sampleInterval = 512*1024);
+        API_DCI_MM void stop();
+
+        // профиль живых выбранных объектов в формате legacy heap profile (pprof)
+        API_DCI_MM std::string dump();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    /*
+     * заливка классов размеров ('A' при выделении, 'F' при освобождении) и карантин освобожденных.
+     * работает только в сборке с DCIMMCONFIG_heapDebug (по умолчанию в Debug), иначе setPoison/setQuarantine
+     * ничего не меняют и возвращают false.
+     * DCI_MM_HEAP_POISON=none|edges|sampled[:N]|full и DCI_MM_HEAP_QUARANTINE=objects задают начальные значения
+     */
+    namespace debug
+    {
+        enum class Poison
+        {
+            none,
+            edges,      // первые и последние 16 байт объекта
+            sampled,    // целиком каждый sampling-й объект, остальные не трогаются
+            full,       // целиком
+        };
+
+        API_DCI_MM bool supported();
+
+        API_DCI_MM bool setPoison(Poison poison, std::size_t sampling = 64);
+        API_DCI_MM Poison poison();
+
+        /*
+         * освобожденные задерживаются по столько на поток (FIFO) прежде чем стать доступными снова,
+         * на выходе из карантина проверяется целость заливки, запись после освобождения - сообщение и abort
+         */
+        API_DCI_MM bool setQuarantine(std::size_t objects);
+        API_DCI_MM std::size_t quarantine();
+    }
+
 
     ////////////////////////////////////////////////////////////////
     static constexpr std::size_t _sizeClassMin = 8;
@@ -31,6 +73,10 @@ namespace dci::mm::heap
         template <std::size_t sizeClass> API_DCI_MM void* allocBySizeClass();
         template <std::size_t sizeClass> API_DCI_MM void freeBySizeClass(void* ptr);
 
+        // то же с выбором класса во время выполнения, size <= _sizeClassMax
+        API_DCI_MM void* allocBySize(std::size_t size);
+        API_DCI_MM void freeBySize(void* ptr, std::size_t size);
+
         inline constexpr std::size_t evalSizeClass(std::size_t size)
         {
             return size <= _sizeClassMin ? _sizeClassMin :
@@ -8,24 +8,123 @@
 #pragma once
 
 #include <dci/mm/heap.hpp>
+#include <dci/utils/compiler.hpp>
 #include <dci/utils/dbg.hpp>
+#include <cstdint>
+#include <new>
 
 namespace dci::mm::heap
 {
+    namespace details::allocable
+    {
+        // размер известен только во время выполнения, но освобождение тоже получает размер
+        inline void* alloc(std::size_t size)
+        {
+            return size > _sizeClassMax ? heap::alloc(size) : allocBySize(size);
+        }
+
+        inline void free(void* ptr, std::size_t size)
+        {
+            return size > _sizeClassMax ? heap::free(ptr) : freeBySize(ptr, size);
+        }
+
+        /*
+         * сверхвыровненные: блок берется с запасом alignment, сдвиг от его начала лежит прямо перед результатом.
+         * классы размеров кратны 16 и начало блока выровнено на 16, поэтому сдвиг не меньше 16 и место под него есть.
+         * только для operator new: при нехватке памяти бросает std::bad_alloc
+         */
+        inline void* align(void* block, std::size_t alignment)
+        {
+            dbgAssert(alignment >= 16 && !(alignment & (alignment-1)));
+
+            //сдвиг пишется в сам блок, без блока operator new может только бросить
+            if(unlikely(!block))
+            {
+                throw std::bad_alloc{};
+            }
+
+            std::uintptr_t payload = (reinterpret_cast<std::uintptr_t>(block) + 16 + alignment - 1) & ~(alignment - 1);
+            if(payload - reinterpret_cast<std::uintptr_t>(block) > alignment)
+            {
+                payload -= alignment;
+            }
+
+            reinterpret_cast<std::size_t*>(payload)[-1] = payload - reinterpret_cast<std::uintptr_t>(block);
+            return reinterpret_cast<void*>(payload);
+        }
+
+        inline void* unalign(void* ptr)
+        {
+            return static_cast<char*>(ptr) - static_cast<std::size_t*>(ptr)[-1];
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////
+    /*
+     * точный sizeof(T) уходит в свой класс размера на этапе компиляции,
+     * наследники, массивы и сверхвыровненные - по размеру, полученному оператором, обратно с sized delete
+     */
     template <class T>
     struct Allocable
     {
-        void* operator new(size_t sz)
+        static void* operator new(std::size_t sz)
         {
-            dbgAssert(sz == sizeof(T));
-            (void)sz;
+            if(likely(sizeof(T) == sz))
+            {
+                return dci::mm::heap::alloc<sizeof(T)>();
+            }
+
+            return details::allocable::alloc(sz);
+        }
 
-            return dci::mm::heap::alloc<sizeof(T)>();
+        static void operator delete(void* ptr, std::size_t sz)
+        {
+            if(likely(sizeof(T) == sz))
+            {
+                return dci::mm::heap::free<sizeof(T)>(ptr);
+            }
+
+            return details::allocable::free(ptr, sz);
+        }
+
+        static void* operator new[](std::size_t sz)
+        {
+            return details::allocable::alloc(sz);
+        }
+
+        static void operator delete[](void* ptr, std::size_t sz)
+        {
+            return details::allocable::free(ptr, sz);
+        }
+
+        static void* operator new(std::size_t sz, std::align_val_t al)
+        {
+            if(likely(sizeof(T) == sz && alignof(T) == static_cast<std::size_t>(al)))
+            {
+                return details::allocable::align(dci::mm::heap::alloc<sizeof(T) + alignof(T)>(), alignof(T));
+            }
+
+            return details::allocable::align(details::allocable::alloc(sz + static_cast<std::size_t>(al)), static_cast<std::size_t>(al));
+        }
+
+        static void operator delete(void* ptr, std::size_t sz, std::align_val_t al)
+        {
+            if(likely(sizeof(T) == sz && alignof(T) == static_cast<std::size_t>(al)))
+            {
+                return dci::mm::heap::free<sizeof(T) + alignof(T)>(details::allocable::unalign(ptr));
+            }
+
+            return details::allocable::free(details::allocable::unalign(ptr), sz + static_cast<std::size_t>(al));
+        }
+
+        static void* operator new[](std::size_t sz, std::align_val_t al)
+        {
+            return details::allocable::align(details::allocable::alloc(sz + static_cast<std::size_t>(al)), static_cast<std::size_t>(al));
         }
 
-        void operator delete(void* ptr)
+        static void operator delete[](void* ptr, std::size_t sz, std::align_val_t al)
         {
-            dci::mm::heap::free<sizeof(T)>(ptr);
+            return details::allocable::free(details::allocable::unalign(ptr), sz + static_cast<std::size_t>(al));
         }
     };
 }
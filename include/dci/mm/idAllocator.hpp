@@ -0,0 +1,210 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include "api.hpp"
+
+#include "idAllocator/id.hpp"
+#include "idAllocator/level.hpp"
+#include "idAllocator/level.ipp"
+#include "idAllocator/orderEvaluator.hpp"
+#include "idAllocator/storage.hpp"
+
+#include <dci/utils/compiler.hpp>
+#include <dci/utils/dbg.hpp>
+
+namespace dci::mm
+{
+    namespace idAllocator
+    {
+        template <std::size_t volume>
+        using Tree = Level<OrderEvaluator<volume>::_order>;
+
+        template <std::size_t volume>
+        static constexpr Storage _defaultStorage = sizeof(Tree<volume>) <= 4096 ? Storage::inplace : Storage::vm;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    /*
+     * плотные целочисленные идентификаторы [0, volume), всегда выдается наименьший свободный
+     */
+    template <std::size_t volume, idAllocator::Storage storage = idAllocator::_defaultStorage<volume>>
+    class IdAllocator
+    {
+    public:
+        using Id = idAllocator::Id;
+        static constexpr Id _badId = idAllocator::_badId;
+        static constexpr std::size_t _volume = volume;
+
+    public:
+        IdAllocator() = default;
+        IdAllocator(const IdAllocator&) = delete;
+        IdAllocator& operator=(const IdAllocator&) = delete;
+
+        Id allocate();
+        bool isAllocated(Id id) const;
+        void deallocate(Id id);
+
+        std::size_t amount() const;
+        Id maxAllocated() const;
+
+        // заполненность битовой карты: f(Id firstId, std::size_t allocated) для каждой непустой строки по _lineVolume идентификаторов
+        static constexpr std::size_t _lineVolume = idAllocator::Level<0>::_volume;
+        template <class F> void forEachLine(F&& f) const;
+
+    public:
+        class ConstIterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Id;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Id*;
+            using reference = Id;
+
+            ConstIterator() = default;
+            ConstIterator(const IdAllocator* owner, Id id) : _owner{owner}, _id{id} {}
+
+            Id operator*() const { return _id; }
+            ConstIterator& operator++() { _id = _owner->nextAllocated(_id+1); return *this; }
+            ConstIterator operator++(int) { ConstIterator res{*this}; ++*this; return res; }
+            bool operator==(const ConstIterator& other) const { return _id == other._id; }
+
+        private:
+            const IdAllocator*  _owner {};
+            Id                  _id {_badId};
+        };
+
+        ConstIterator begin() const;
+        ConstIterator end() const;
+
+        Id nextAllocated(Id from) const;
+
+    private:
+        using Tree = idAllocator::Tree<volume>;
+
+        void fit();
+
+        idAllocator::details::Holder<Tree, storage> _holder;
+        std::size_t _amount {};
+        Id _maxAllocated {};
+    };
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    typename IdAllocator<volume, storage>::Id IdAllocator<volume, storage>::allocate()
+    {
+        if(unlikely(_amount >= volume))
+        {
+            return _badId;
+        }
+
+        Id id = _holder.tree().allocate();
+        dbgAssert(_badId != id && id < volume);
+        ++_amount;
+
+        //наименьший свободный, значит id <= _maxAllocated+1, его линия лежит в пределах уже открытого запаса
+        if(id > _maxAllocated)
+        {
+            _maxAllocated = id;
+            fit();
+        }
+
+        return id;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    bool IdAllocator<volume, storage>::isAllocated(Id id) const
+    {
+        if(_maxAllocated < id)
+        {
+            return false;
+        }
+
+        return _holder.tree().isAllocated(id);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    void IdAllocator<volume, storage>::deallocate(Id id)
+    {
+        dbgAssert(isAllocated(id));
+        _holder.tree().deallocate(id);
+        --_amount;
+
+        if(_maxAllocated == id)
+        {
+            _maxAllocated = _holder.tree().maxAllocated();
+            fit();
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    std::size_t IdAllocator<volume, storage>::amount() const
+    {
+        return _amount;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    typename IdAllocator<volume, storage>::Id IdAllocator<volume, storage>::maxAllocated() const
+    {
+        return _amount ? _maxAllocated : _badId;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    template <class F>
+    void IdAllocator<volume, storage>::forEachLine(F&& f) const
+    {
+        if(!_amount)
+        {
+            return;
+        }
+
+        //счетчики поддеревьев за _maxAllocated нулевые, в неоткрытые страницы обход не заходит
+        return _holder.tree().forEachLine(std::forward<F>(f));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    typename IdAllocator<volume, storage>::ConstIterator IdAllocator<volume, storage>::begin() const
+    {
+        return ConstIterator{this, nextAllocated(0)};
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    typename IdAllocator<volume, storage>::ConstIterator IdAllocator<volume, storage>::end() const
+    {
+        return ConstIterator{this, _badId};
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    typename IdAllocator<volume, storage>::Id IdAllocator<volume, storage>::nextAllocated(Id from) const
+    {
+        if(!_amount || from > _maxAllocated)
+        {
+            return _badId;
+        }
+
+        return _holder.tree().nextAllocated(from);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t volume, idAllocator::Storage storage>
+    void IdAllocator<volume, storage>::fit()
+    {
+        _holder.fit(_holder.tree().requiredAreaFor(_maxAllocated));
+    }
+}
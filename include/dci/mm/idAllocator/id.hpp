@@ -8,9 +8,9 @@
 #pragma once
 #include <cstddef>
 
-namespace dci::mm::impl::bitIndex
+namespace dci::mm::idAllocator
 {
-    using Address = std::size_t;
+    using Id = std::size_t;
 
-    static constexpr Address _badAddress = static_cast<Address>(-1);
+    static constexpr Id _badId = static_cast<Id>(-1);
 }
@@ -7,12 +7,12 @@
 
 #pragma once
 
-#include "address.hpp"
+#include "id.hpp"
 
 #include <cstdint>
 #include <type_traits>
 
-namespace dci::mm::impl::bitIndex
+namespace dci::mm::idAllocator
 {
     template <std::size_t order, std::size_t lineSize=64>
     class Level;
@@ -28,11 +28,14 @@ namespace dci::mm::impl::bitIndex
 
     public:
 
-        Address allocate();
-        bool isAllocated(Address address) const;
-        void deallocate(Address address);
-        Address maxAllocatedAddress() const;
-        std::size_t requiredAreaForAddress(Address address) const;
+        Id allocate();
+        bool isAllocated(Id id) const;
+        void deallocate(Id id);
+        Id maxAllocated() const;
+        Id nextAllocated(Id from) const;
+        std::size_t requiredAreaFor(Id id) const;
+
+        template <class F> void forEachLine(F&& f) const;
 
     private:
         using BitHolder = std::uint64_t;
@@ -44,7 +47,7 @@ namespace dci::mm::impl::bitIndex
     };
 
 
-    namespace
+    namespace details
     {
         template <std::size_t value>
         using coveredUnsignedIntegral =
@@ -65,16 +68,20 @@ namespace dci::mm::impl::bitIndex
     {
     public:
 
-        Address allocate();
-        bool isAllocated(Address address) const;
-        void deallocate(Address address);
-        Address maxAllocatedAddress() const;
-        std::size_t requiredAreaForAddress(Address address) const;
+        Id allocate();
+        bool isAllocated(Id id) const;
+        void deallocate(Id id);
+        Id maxAllocated() const;
+        Id nextAllocated(Id from) const;
+        std::size_t requiredAreaFor(Id id) const;
+
+        // f(Id firstId, std::size_t allocated) для каждой непустой строки нижнего уровня, пустые поддеревья пропускаются по счетчикам
+        template <class F> void forEachLine(F&& f) const;
 
     private:
         using SubLevel = Level<order-1, lineSize>;
 
-        using Counter = coveredUnsignedIntegral<SubLevel::_volume>;
+        using Counter = details::coveredUnsignedIntegral<SubLevel::_volume>;
 
     public:
         static constexpr std::size_t _subLevelsAmount = (lineSize / sizeof(Counter));
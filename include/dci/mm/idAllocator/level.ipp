@@ -0,0 +1,266 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "id.hpp"
+#include "level.hpp"
+#include <dci/utils/dbg.hpp>
+
+namespace dci::mm::idAllocator
+{
+
+    namespace details
+    {
+//        std::size_t bits_itz(std::uint8_t x);//index of least significant zero or overflow if absent
+//        std::size_t bits_itz(std::uint16_t x);
+//        std::size_t bits_itz(std::uint32_t x);
+
+        inline std::size_t bits_itz(std::uint64_t x)
+        {
+            std::size_t res = static_cast<std::size_t>(__builtin_ffsll(static_cast<long long>(~x)));
+            if(!res)
+            {
+                return 64;
+            }
+
+            return res - 1;
+        }
+
+        inline std::size_t bits_clz(std::uint64_t x)
+        {
+            if(!x)
+            {
+                return 64;
+            }
+
+            return static_cast<std::size_t>(__builtin_clzll(x));
+        }
+
+        inline std::size_t bits_ctz(std::uint64_t x)
+        {
+            if(!x)
+            {
+                return 64;
+            }
+
+            return static_cast<std::size_t>(__builtin_ctzll(x));
+        }
+    }
+
+    template <std::size_t lineSize>
+    Id Level<0, lineSize>::allocate()
+    {
+        for(std::size_t bitHolderIdx(0); bitHolderIdx<_bitHoldersAmount; ++bitHolderIdx)
+        {
+            Id id = details::bits_itz(_bitHolders[bitHolderIdx]);
+            if(id < 64)
+            {
+                _bitHolders[bitHolderIdx] |= (1ULL << id);
+                return id + bitHolderIdx * 64;
+            }
+        }
+
+        return _badId;
+    }
+
+    template <std::size_t lineSize>
+    bool Level<0, lineSize>::isAllocated(Id id) const
+    {
+        std::size_t bitHolderIdx = id / 64;
+        dbgAssert(bitHolderIdx < _bitHoldersAmount);
+
+        std::size_t bitHolderId = id % 64;
+
+        return (_bitHolders[bitHolderIdx] & (1ULL << bitHolderId)) ? true : false;
+    }
+
+    template <std::size_t lineSize>
+    void Level<0, lineSize>::deallocate(Id id)
+    {
+        std::size_t bitHolderIdx = id / 64;
+        dbgAssert(bitHolderIdx < _bitHoldersAmount);
+
+        std::size_t bitHolderId = id % 64;
+
+        _bitHolders[bitHolderIdx] &= ~(1ULL << bitHolderId);
+    }
+
+    template <std::size_t lineSize>
+    Id Level<0, lineSize>::maxAllocated() const
+    {
+        for(std::size_t bitHolderIdx(_bitHoldersAmount-1); bitHolderIdx<_bitHoldersAmount; --bitHolderIdx)
+        {
+            std::size_t clz = details::bits_clz(_bitHolders[bitHolderIdx]);
+            if(clz < 64)
+            {
+                return (64 - clz - 1) + bitHolderIdx * 64;
+            }
+        }
+
+        return 0;
+    }
+
+    template <std::size_t lineSize>
+    Id Level<0, lineSize>::nextAllocated(Id from) const
+    {
+        for(std::size_t bitHolderIdx(from / 64); bitHolderIdx<_bitHoldersAmount; ++bitHolderIdx)
+        {
+            BitHolder bitHolder = _bitHolders[bitHolderIdx];
+            if(bitHolderIdx == from / 64)
+            {
+                bitHolder &= ~0ULL << (from % 64);
+            }
+
+            std::size_t ctz = details::bits_ctz(bitHolder);
+            if(ctz < 64)
+            {
+                return ctz + bitHolderIdx * 64;
+            }
+        }
+
+        return _badId;
+    }
+
+    template <std::size_t lineSize>
+    std::size_t Level<0, lineSize>::requiredAreaFor(Id id) const
+    {
+        (void)id;
+        return sizeof(Level<0, lineSize>);
+    }
+
+    template <std::size_t lineSize>
+    template <class F>
+    void Level<0, lineSize>::forEachLine(F&& f) const
+    {
+        std::size_t allocated{};
+        for(BitHolder bitHolder : _bitHolders)
+        {
+            allocated += static_cast<std::size_t>(__builtin_popcountll(bitHolder));
+        }
+
+        if(allocated)
+        {
+            f(Id{0}, allocated);
+        }
+    }
+
+
+
+
+
+    template <std::size_t order, std::size_t lineSize>
+    Id Level<order, lineSize>::allocate()
+    {
+        for(std::size_t subLevelIdx(0); subLevelIdx<_subLevelsAmount; ++subLevelIdx)
+        {
+            if(_subLevelCounters[subLevelIdx] < SubLevel::_volume)
+            {
+                ++_subLevelCounters[subLevelIdx];
+                return _subLevels[subLevelIdx].allocate() + subLevelIdx * SubLevel::_volume;
+            }
+        }
+
+        return _badId;
+    }
+
+    template <std::size_t order, std::size_t lineSize>
+    bool Level<order, lineSize>::isAllocated(Id id) const
+    {
+        std::size_t subLevelIdx = id / SubLevel::_volume;
+        Id subLevelId = id % SubLevel::_volume;
+
+        return _subLevels[subLevelIdx].isAllocated(subLevelId);
+    }
+
+    template <std::size_t order, std::size_t lineSize>
+    void Level<order, lineSize>::deallocate(Id id)
+    {
+        std::size_t subLevelIdx = id / SubLevel::_volume;
+        Id subLevelId = id % SubLevel::_volume;
+
+        dbgAssert(_subLevelCounters[subLevelIdx]);
+        --_subLevelCounters[subLevelIdx];
+
+        return _subLevels[subLevelIdx].deallocate(subLevelId);
+    }
+
+    template <std::size_t order, std::size_t lineSize>
+    Id Level<order, lineSize>::maxAllocated() const
+    {
+        for(std::size_t subLevelIdx(_subLevelsAmount-1); subLevelIdx<_subLevelsAmount; --subLevelIdx)
+        {
+            if(_subLevelCounters[subLevelIdx])
+            {
+                return _subLevels[subLevelIdx].maxAllocated() + subLevelIdx * SubLevel::_volume;
+            }
+        }
+
+        return 0;
+    }
+
+    template <std::size_t order, std::size_t lineSize>
+    Id Level<order, lineSize>::nextAllocated(Id from) const
+    {
+        for(std::size_t subLevelIdx(from / SubLevel::_volume); subLevelIdx<_subLevelsAmount; ++subLevelIdx)
+        {
+            if(_subLevelCounters[subLevelIdx])
+            {
+                Id subLevelFrom = subLevelIdx == from / SubLevel::_volume ? from % SubLevel::_volume : 0;
+                Id id = _subLevels[subLevelIdx].nextAllocated(subLevelFrom);
+                if(_badId != id)
+                {
+                    return id + subLevelIdx * SubLevel::_volume;
+                }
+            }
+        }
+
+        return _badId;
+    }
+
+    template <std::size_t order, std::size_t lineSize>
+    std::size_t Level<order, lineSize>::requiredAreaFor(Id id) const
+    {
+        std::size_t subLevelIdx = id / SubLevel::_volume;
+        Id subLevelId = id % SubLevel::_volume;
+
+        return _subLevels[subLevelIdx].requiredAreaFor(subLevelId) + subLevelIdx * sizeof(SubLevel);
+    }
+
+    template <std::size_t order, std::size_t lineSize>
+    template <class F>
+    void Level<order, lineSize>::forEachLine(F&& f) const
+    {
+        constexpr std::size_t lineVolume = Level<0, lineSize>::_volume;
+
+        for(std::size_t subLevelIdx(0); subLevelIdx<_subLevelsAmount; ++subLevelIdx)
+        {
+            Id base = subLevelIdx * SubLevel::_volume;
+
+            if(!_subLevelCounters[subLevelIdx])
+            {
+                continue;
+            }
+
+            //полное поддерево известно без спуска
+            if(SubLevel::_volume == _subLevelCounters[subLevelIdx])
+            {
+                for(Id line(0); line<SubLevel::_volume; line += lineVolume)
+                {
+                    f(base + line, lineVolume);
+                }
+                continue;
+            }
+
+            _subLevels[subLevelIdx].forEachLine([&](Id id, std::size_t allocated)
+            {
+                f(base + id, allocated);
+            });
+        }
+    }
+
+}
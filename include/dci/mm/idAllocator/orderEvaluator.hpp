@@ -9,7 +9,7 @@
 
 #include "level.hpp"
 
-namespace dci::mm::impl::bitIndex
+namespace dci::mm::idAllocator
 {
     template <std::size_t volume, std::size_t base=0>
     struct OrderEvaluator
@@ -0,0 +1,147 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "../api.hpp"
+#include "../heap.hpp"
+
+#include <cstring>
+#include <new>
+
+namespace dci::mm::idAllocator
+{
+    enum class Storage
+    {
+        inplace,    // дерево прямо внутри аллокатора, без защиты страниц, для небольших объемов
+        heap,       // дерево в куче, целиком
+        vm,         // дерево в зарезервированном vm, страницы открываются по мере роста максимального id
+    };
+
+    namespace details
+    {
+        API_DCI_MM void* vmReserve(std::size_t size);
+        API_DCI_MM void vmRelease(void* area, std::size_t size);
+        API_DCI_MM std::size_t vmFit(void* area, std::size_t size, std::size_t committed, std::size_t required);
+
+        ////////////////////////////////////////////////////////////////
+        template <class Tree, Storage storage>
+        class Holder;
+
+        ////////////////////////////////////////////////////////////////
+        template <class Tree>
+        class Holder<Tree, Storage::inplace>
+        {
+        public:
+            Tree& tree()
+            {
+                return _tree;
+            }
+
+            const Tree& tree() const
+            {
+                return _tree;
+            }
+
+            void fit(std::size_t required)
+            {
+                (void)required;
+            }
+
+        private:
+            Tree _tree{};
+        };
+
+        ////////////////////////////////////////////////////////////////
+        template <class Tree>
+        class Holder<Tree, Storage::heap>
+        {
+        public:
+            Holder()
+                : _tree{static_cast<Tree*>(heap::alloc(sizeof(Tree)))}
+            {
+                if(!_tree)
+                {
+                    throw std::bad_alloc{};
+                }
+
+                std::memset(static_cast<void*>(_tree), 0, sizeof(Tree));
+            }
+
+            Holder(const Holder&) = delete;
+            Holder& operator=(const Holder&) = delete;
+
+            ~Holder()
+            {
+                heap::free(_tree);
+            }
+
+            Tree& tree()
+            {
+                return *_tree;
+            }
+
+            const Tree& tree() const
+            {
+                return *_tree;
+            }
+
+            void fit(std::size_t required)
+            {
+                (void)required;
+            }
+
+        private:
+            Tree* _tree;
+        };
+
+        ////////////////////////////////////////////////////////////////
+        template <class Tree>
+        class Holder<Tree, Storage::vm>
+        {
+        public:
+            Holder()
+                : _tree{static_cast<Tree*>(vmReserve(sizeof(Tree)))}
+                , _committed{}
+            {
+                if(!_tree)
+                {
+                    throw std::bad_alloc{};
+                }
+
+                fit(_tree->requiredAreaFor(0));
+            }
+
+            Holder(const Holder&) = delete;
+            Holder& operator=(const Holder&) = delete;
+
+            ~Holder()
+            {
+                vmRelease(_tree, sizeof(Tree));
+            }
+
+            Tree& tree()
+            {
+                return *_tree;
+            }
+
+            const Tree& tree() const
+            {
+                return *_tree;
+            }
+
+            void fit(std::size_t required)
+            {
+                _committed = vmFit(_tree, sizeof(Tree), _committed, required);
+            }
+
+        private:
+            Tree*       _tree;
+            std::size_t _committed;
+        };
+    }
+}
@@ -0,0 +1,42 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+#include <cstddef>
+#include <string>
+#include "api.hpp"
+
+namespace dci::mm::reclaim
+{
+    ////////////////////////////////////////////////////////////////
+    /*
+     * отдача придержанной памяти системе под давлением: PSI (/proc/pressure/memory)
+     * и приближение cgroup v2 memory.current к memory.high. пути задаются, можно подсунуть свои файлы
+     */
+    struct Options
+    {
+        std::string _psiPath    {"/proc/pressure/memory"};
+        std::string _cgroupDir  {};     // с memory.current и memory.high, пусто - своя группа из /proc/self/cgroup
+
+        double      _someAvg10  {10.0}; // some avg10 из PSI, процент времени ожидания памяти за 10с
+        double      _highRatio  {0.9};  // memory.current / memory.high
+        std::size_t _periodMs   {1000};
+    };
+
+    // фоновый поток, опрашивающий давление раз в период
+    API_DCI_MM void start(const Options& options = {});
+    API_DCI_MM void stop();
+
+    // однократная проверка, при давлении - trim; true если давление было
+    API_DCI_MM bool poll(const Options& options = {});
+
+    // без проверки: запасные слябы потоков, свободные слябы, готовые стеки, затем обработчик; возвращает отданный объем
+    API_DCI_MM std::size_t trim();
+
+    // зовется из trim, например чтобы сжать приостановленные стеки через Context::compact
+    API_DCI_MM void setPressureHandler(void(*)());
+}
@@ -8,11 +8,15 @@
 #pragma once
 #include <cstddef>
 #include "api.hpp"
+#include "stack/options.hpp"
 #include <dci/himpl.hpp>
 #include <dci/mm/implMetaInfo.hpp>
+#include <vector>
 
 namespace dci::mm
 {
+    class StackSpace;
+
     ////////////////////////////////////////////////////////////////
     class API_DCI_MM Stack
         : public dci::himpl::FaceLayout<Stack, impl::Stack>
@@ -28,7 +32,13 @@ namespace dci::mm
         Stack& operator=(const Stack& from) = delete;
         Stack& operator=(Stack&& from);
 
-        void initialize();
+        void initialize(const stack::Options& options = {});
+        void initialize(StackSpace& space, const stack::Options& options = {});
+
+        // при исчерпании пула - false вместо abort
+        bool tryInitialize(const stack::Options& options = {});
+        bool tryInitialize(StackSpace& space, const stack::Options& options = {});
+
         bool initialized() const;
 
     public:
@@ -39,6 +49,51 @@ namespace dci::mm
         char* end() const;
         std::size_t size() const;
 
+        std::size_t committedBytes() const;
+
+        // наибольшая глубина за время жизни с точностью до страницы, по отказам страниц (не меньше предоткрытого), compact ее не снижает
+        std::size_t peakUsage() const;
+
         void compact();
+
+        // то же для приостановленного стека снаружи, suspendedSp - его сохраненная вершина
+        void compact(void* suspendedSp);
+
+        // спящий стек: открытые страницы сжаты в кучу и отданы системе, первое обращение к ним или wake разворачивает обратно
+        bool hibernate();
+        void wake();
+        bool hibernated() const;
+        std::size_t hibernatedBytes() const;
     };
 }
+
+namespace dci::mm::stack
+{
+    API_DCI_MM std::size_t decommittedBytes();
+
+    // [pages] = количество живых стеков, чья пиковая глубина (peakUsage) в страницах равна pages
+    API_DCI_MM std::vector<std::size_t> peakPagesHistogram();
+
+    // построить в фоне count стеков с pagesEach открытыми страницами, initialize с подходящими опциями возьмет готовый
+    API_DCI_MM void warm(std::size_t count, std::size_t pagesEach);
+
+    // сколько готовых еще не разобрано
+    API_DCI_MM std::size_t warmAmount();
+
+    // потолок количества одновременно живых стеков, не выше собранного в конфигурации; изначально DCI_MM_STACK_LIMIT
+    API_DCI_MM void setLimit(std::size_t stacks);
+    API_DCI_MM std::size_t limit();
+
+    // зарезервированное под стеки адресное пространство, растет кусками по мере надобности
+    API_DCI_MM std::size_t reservedBytes();
+
+    // сколько стеков сейчас живо, без стеков обработчиков SIGSEGV потоков
+    API_DCI_MM std::size_t allocatedStacks();
+
+    /*
+     * поток, создающий стеки или переключающийся через Context, получает свой стек обработчика SIGSEGV автоматически;
+     * поток, исполняющий чужие стеки иначе (ucontext, свой планировщик), должен вызвать это до первого переключения на них.
+     * false - стек не выделен (идентификаторы исчерпаны), исполнять Stack в этом потоке нельзя
+     */
+    API_DCI_MM bool prepareThread();
+}
@@ -0,0 +1,52 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+#include <cstddef>
+#include "../api.hpp"
+
+namespace dci::mm
+{
+    class Stack;
+}
+
+namespace dci::mm::stack
+{
+    ////////////////////////////////////////////////////////////////
+    /*
+     * копия использованной части стека для режима разделяемых стеков: много сопрограмм по очереди исполняются
+     * на немногих Stack, при приостановке занятая часть уходит в буфер по размеру, перед возобновлением
+     * возвращается по тем же адресам. save/restore вызываются не на самом этом стеке
+     */
+    class API_DCI_MM Image
+    {
+    public:
+        Image() = default;
+        Image(const Image&) = delete;
+        Image(Image&& from);
+        ~Image();
+
+        Image& operator=(const Image&) = delete;
+        Image& operator=(Image&& from);
+
+        // от указателя стека до дна (в сторону, противоположную росту); false - не хватило памяти, образ остается пустым
+        bool save(const Stack& stack, const void* sp);
+
+        // указатель стека неизвестен - вся открытая часть, спящий стек при этом разворачивается
+        bool save(const Stack& stack);
+
+        void restore(const Stack& stack) const;
+
+        bool empty() const;
+        std::size_t size() const;
+        void clear();
+
+    private:
+        char*       _data {};
+        std::size_t _size {};
+    };
+}
@@ -0,0 +1,56 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+#include <cstddef>
+#include "api.hpp"
+#include "stats.hpp"
+#include <dci/himpl.hpp>
+#include <dci/mm/implMetaInfo.hpp>
+#include <vector>
+
+namespace dci::mm
+{
+    class Stack;
+
+    ////////////////////////////////////////////////////////////////
+    /*
+     * отдельный пул стеков со своим резервированием адресного пространства, пределом и статистикой,
+     * стеки берутся из него через Stack::initialize(space)/tryInitialize(space) и не должны его пережить.
+     * функции dci::mm::stack:: относятся к основному пулу.
+     * одновременно живых пулов вместе с основным не больше 64, сверх того конструктор бросает std::length_error
+     */
+    class API_DCI_MM StackSpace
+        : public dci::himpl::FaceLayout<StackSpace, impl::VirtualSpace>
+    {
+        using Base = dci::himpl::FaceLayout<StackSpace, impl::VirtualSpace>;
+        friend class Stack;
+
+    public:
+        StackSpace();
+        explicit StackSpace(std::size_t limit);
+        StackSpace(const StackSpace& from) = delete;
+        StackSpace(StackSpace&& from) = delete;
+        ~StackSpace();
+
+        StackSpace& operator=(const StackSpace& from) = delete;
+        StackSpace& operator=(StackSpace&& from) = delete;
+
+    public:
+        // потолок количества одновременно живых стеков пула, не выше собранного в конфигурации
+        void setLimit(std::size_t stacks);
+        std::size_t limit() const;
+
+        std::size_t reservedBytes() const;
+        std::size_t allocatedStacks() const;
+        std::vector<std::size_t> peakPagesHistogram() const;
+        stats::Stacks occupancy() const;
+
+        void warm(std::size_t count, std::size_t pagesEach);
+        std::size_t warmAmount() const;
+    };
+}
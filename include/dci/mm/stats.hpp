@@ -0,0 +1,105 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "api.hpp"
+
+namespace dci::mm::stats
+{
+    ////////////////////////////////////////////////////////////////
+    // длительности в тиках, [idx] - количество замеров в диапазоне [2^idx, 2^(idx+1))
+    struct Histogram
+    {
+        static constexpr std::size_t _bucketsAmount = 64;
+
+        std::uint64_t _buckets[_bucketsAmount] {};
+        std::uint64_t _amount {};
+        std::uint64_t _sumTicks {};
+    };
+
+    ////////////////////////////////////////////////////////////////
+    struct Vm
+    {
+        Histogram       _handledFaults;
+        std::uint64_t   _unhandledFaults {};
+
+        Histogram       _protects;
+        std::uint64_t   _failedProtects {};
+    };
+
+    API_DCI_MM Vm vm();
+
+    ////////////////////////////////////////////////////////////////
+    /*
+     * заполненность слябов кучи, обход всех слябов без остановки потоков - снимок приблизительный,
+     * но достаточно дешевый для периодического опроса.
+     * _occupancy[idx] - слябы с долей занятых мест в [idx, idx+1)/_occupancyBuckets, полные в последнем
+     */
+    struct Heap
+    {
+        static constexpr std::size_t _classesAmount = 4096 / 16 + 1;// [heap::details::evalSizeClass(size) / heap::_sizeClassStep]
+        static constexpr std::size_t _occupancyBuckets = 10;
+
+        struct SizeClass
+        {
+            std::uint64_t _slabs {};        // в работе, с пустыми запасными
+            std::uint64_t _emptySlabs {};
+            std::uint64_t _partialSlabs {};
+            std::uint64_t _objects {};      // занятых мест
+            std::uint64_t _capacity {};     // мест во всех слябах
+        };
+
+        SizeClass       _classes[_classesAmount] {};
+        std::uint64_t   _occupancy[_occupancyBuckets] {};
+
+        std::uint64_t   _slabs {};
+        std::uint64_t   _emptySlabs {};
+        std::uint64_t   _partialSlabs {};
+        std::uint64_t   _freeSlabs {};      // в резерве арены
+        std::uint64_t   _purgedSlabs {};    // из них уже отданы системе
+
+        std::uint64_t   _usedBytes {};      // под живыми объектами
+        std::uint64_t   _committedBytes {}; // слябы в работе и не отданные свободные
+        std::uint64_t   _wastedBytes {};    // _committedBytes - _usedBytes: свободные места, заголовки, хвосты, резерв
+    };
+
+    API_DCI_MM Heap heap();
+
+    ////////////////////////////////////////////////////////////////
+    /*
+     * фрагментация пространства стеков: идентификатор стека - его слот в зарезервированной области,
+     * дыры ниже наибольшего занятого держат резерв и строки битовой карты.
+     * _occupancy[idx] - строки по _lineVolume идентификаторов с долей занятых в [idx, idx+1)/_occupancyBuckets, пустые в первом
+     */
+    struct Stacks
+    {
+        static constexpr std::size_t _occupancyBuckets = 10;
+
+        std::uint64_t   _allocated {};
+        std::uint64_t   _span {};           // идентификаторов до наибольшего занятого включительно
+        std::uint64_t   _holes {};          // свободных внутри _span
+        double          _externalFragmentation {};// _holes / _span
+
+        std::uint64_t   _lineVolume {};
+        std::uint64_t   _lines {};          // покрывающих _span
+        std::uint64_t   _emptyLines {};
+        std::uint64_t   _partialLines {};
+        std::uint64_t   _occupancy[_occupancyBuckets] {};
+
+        std::uint64_t   _reservedBytes {};
+        std::uint64_t   _spanBytes {};      // адресное пространство под _span
+        std::uint64_t   _warmCommittedBytes {};// открыто у простаивающих заранее построенных стеков
+    };
+
+    // основное пространство стеков, отдельные - StackSpace::occupancy
+    API_DCI_MM Stacks stacks();
+
+    // оценка частоты тиков, первый вызов калибрует
+    API_DCI_MM double ticksPerSecond();
+}
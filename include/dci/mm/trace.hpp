@@ -0,0 +1,54 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "api.hpp"
+
+namespace dci::mm::trace
+{
+    ////////////////////////////////////////////////////////////////
+    /*
+     * запись операций кучи и стеков для последующего воспроизведения (mm-replay).
+     * собирается только с DCIMM_TRACE, иначе start возвращает false и вызовы в куче ничего не стоят.
+     * каждый поток копит записи в своем буфере и сбрасывает его в файл целиком, порядок в файле - по _ticks
+     */
+    enum class Op : std::uint8_t
+    {
+        alloc,
+        free,
+        stackAlloc,
+        stackFree,
+    };
+
+    struct Record
+    {
+        std::uint64_t   _ticks;
+        std::uint64_t   _ptr;       // идентификатор объекта - его адрес, живые не совпадают
+        std::uint32_t   _size;      // класс размера или размер, для free из общей кучи - 0, для стека - _precommitPages
+        std::uint16_t   _thread;
+        Op              _op;
+        std::uint8_t    _reserved;
+    };
+    static_assert(sizeof(Record) == 24);
+
+    struct FileHeader
+    {
+        char            _magic[8];  // _magicValue
+        std::uint32_t   _version;
+        std::uint32_t   _recordSize;
+        double          _ticksPerSecond;
+    };
+
+    static constexpr char _magicValue[8] = {'d','c','i','m','m','t','r','c'};
+    static constexpr std::uint32_t _version = 1;
+
+    // DCI_MM_TRACE=path включает запись при загрузке
+    API_DCI_MM bool start(const char* path);
+    API_DCI_MM void stop();
+}
@@ -0,0 +1,309 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/mm/heap.hpp>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+/*
+ * замена глобальных operator new/delete, а в сборке для LD_PRELOAD (DCI_MM_MALLOC_LIBC) - и семейства malloc
+ *
+ * перед каждым блоком лежит заголовок с запрошенным размером и сдвигом от начала выделенной области,
+ * по нему free без размера находит нужный класс. Малые блоки идут в пулы классов размеров, крупные - в heap::alloc,
+ * который сам берет память у штатной кучи в обход этой подмены.
+ * классы размеров свои у каждого потока, освобождение из чужого уходит в очередь владельца
+ */
+
+namespace dci::mm::malloc
+{
+    namespace
+    {
+        struct Header
+        {
+            std::size_t _total;
+            std::size_t _shift;
+        };
+
+        constexpr std::size_t _headerSize = 16;
+        constexpr std::size_t _minAlignment = 16;
+        static_assert(sizeof(Header) == _headerSize);
+
+        Header* header(void* ptr)
+        {
+            return reinterpret_cast<Header*>(static_cast<char *>(ptr) - _headerSize);
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void* alloc(std::size_t size, std::size_t alignment = _minAlignment) noexcept
+        {
+            if(alignment < _minAlignment)
+            {
+                alignment = _minAlignment;
+            }
+
+            //заголовок плюс запас на выравнивание сверх того, что пулы и штатная куча дают сами
+            std::size_t overhead = _headerSize + alignment - _minAlignment;
+            if(size > SIZE_MAX - overhead)
+            {
+                return nullptr;
+            }
+            std::size_t total = size + overhead;
+
+            void* block;
+            if(total <= heap::_sizeClassMax)
+            {
+                block = heap::details::allocBySize(total);
+            }
+            else
+            {
+                block = heap::alloc(total);
+            }
+
+            if(!block)
+            {
+                return nullptr;
+            }
+
+            std::uintptr_t payload = reinterpret_cast<std::uintptr_t>(block) + _headerSize;
+            payload = (payload + alignment - 1) & ~(alignment - 1);
+
+            void* ptr = reinterpret_cast<void*>(payload);
+            *header(ptr) = Header{total, payload - reinterpret_cast<std::uintptr_t>(block)};
+            return ptr;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void free(void* ptr) noexcept
+        {
+            if(!ptr)
+            {
+                return;
+            }
+
+            Header h = *header(ptr);
+            void* block = static_cast<char *>(ptr) - h._shift;
+
+            if(h._total <= heap::_sizeClassMax)
+            {
+                return heap::details::freeBySize(block, h._total);
+            }
+
+            return heap::free(block);
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::size_t usableSize(void* ptr) noexcept
+        {
+            if(!ptr)
+            {
+                return 0;
+            }
+
+            const Header& h = *header(ptr);
+            std::size_t capacity = h._total <= heap::_sizeClassMax ? heap::details::evalSizeClass(h._total) : h._total;
+            return capacity - h._shift;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void* newImpl(std::size_t size, std::size_t alignment = _minAlignment)
+        {
+            for(;;)
+            {
+                if(void* ptr = alloc(size, alignment))
+                {
+                    return ptr;
+                }
+
+                std::new_handler handler = std::get_new_handler();
+                if(!handler)
+                {
+                    throw std::bad_alloc{};
+                }
+                handler();
+            }
+        }
+
+        void* newImpl(std::size_t size, std::size_t alignment, const std::nothrow_t&) noexcept
+        {
+            try
+            {
+                return newImpl(size, alignment);
+            }
+            catch(...)
+            {
+                return nullptr;
+            }
+        }
+    }
+}
+
+namespace mm = dci::mm::malloc;
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+void* operator new(std::size_t size) { return mm::newImpl(size); }
+void* operator new[](std::size_t size) { return mm::newImpl(size); }
+void* operator new(std::size_t size, const std::nothrow_t& nt) noexcept { return mm::newImpl(size, mm::_minAlignment, nt); }
+void* operator new[](std::size_t size, const std::nothrow_t& nt) noexcept { return mm::newImpl(size, mm::_minAlignment, nt); }
+void* operator new(std::size_t size, std::align_val_t al) { return mm::newImpl(size, static_cast<std::size_t>(al)); }
+void* operator new[](std::size_t size, std::align_val_t al) { return mm::newImpl(size, static_cast<std::size_t>(al)); }
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t& nt) noexcept { return mm::newImpl(size, static_cast<std::size_t>(al), nt); }
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t& nt) noexcept { return mm::newImpl(size, static_cast<std::size_t>(al), nt); }
+
+void operator delete(void* ptr) noexcept { mm::free(ptr); }
+void operator delete[](void* ptr) noexcept { mm::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { mm::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { mm::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { mm::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { mm::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { mm::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { mm::free(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { mm::free(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { mm::free(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { mm::free(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { mm::free(ptr); }
+
+#if defined(DCI_MM_MALLOC_LIBC)
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+namespace
+{
+    bool isPowerOf2(std::size_t v)
+    {
+        return v && !(v & (v-1));
+    }
+}
+
+extern "C"
+{
+    __attribute__((visibility("default"))) void* malloc(std::size_t size)
+    {
+        void* ptr = mm::alloc(size);
+        if(!ptr) errno = ENOMEM;
+        return ptr;
+    }
+
+    __attribute__((visibility("default"))) void free(void* ptr)
+    {
+        return mm::free(ptr);
+    }
+
+    __attribute__((visibility("default"))) void* calloc(std::size_t amount, std::size_t size)
+    {
+        if(size && amount > SIZE_MAX / size)
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        void* ptr = mm::alloc(amount * size);
+        if(!ptr)
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        std::memset(ptr, 0, amount * size);
+        return ptr;
+    }
+
+    __attribute__((visibility("default"))) void* realloc(void* ptr, std::size_t size)
+    {
+        if(!ptr)
+        {
+            return malloc(size);
+        }
+
+        if(!size)
+        {
+            mm::free(ptr);
+            return nullptr;
+        }
+
+        std::size_t usable = mm::usableSize(ptr);
+        if(size <= usable && size > usable/2)
+        {
+            return ptr;
+        }
+
+        void* res = mm::alloc(size);
+        if(!res)
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        std::memcpy(res, ptr, size < usable ? size : usable);
+        mm::free(ptr);
+        return res;
+    }
+
+    // штатная reallocarray зовет __libc_realloc напрямую, с нашими указателями ей нельзя
+    __attribute__((visibility("default"))) void* reallocarray(void* ptr, std::size_t amount, std::size_t size)
+    {
+        if(size && amount > SIZE_MAX / size)
+        {
+            errno = ENOMEM;
+            return nullptr;
+        }
+
+        return realloc(ptr, amount * size);
+    }
+
+    __attribute__((visibility("default"))) int posix_memalign(void** res, std::size_t alignment, std::size_t size)
+    {
+        if(!isPowerOf2(alignment) || alignment % sizeof(void*))
+        {
+            return EINVAL;
+        }
+
+        void* ptr = mm::alloc(size, alignment);
+        if(!ptr)
+        {
+            return ENOMEM;
+        }
+
+        *res = ptr;
+        return 0;
+    }
+
+    __attribute__((visibility("default"))) void* aligned_alloc(std::size_t alignment, std::size_t size)
+    {
+        if(!isPowerOf2(alignment))
+        {
+            errno = EINVAL;
+            return nullptr;
+        }
+
+        void* ptr = mm::alloc(size, alignment);
+        if(!ptr) errno = ENOMEM;
+        return ptr;
+    }
+
+    __attribute__((visibility("default"))) void* memalign(std::size_t alignment, std::size_t size)
+    {
+        return aligned_alloc(alignment, size);
+    }
+
+    __attribute__((visibility("default"))) void* valloc(std::size_t size)
+    {
+        return aligned_alloc(4096, size);
+    }
+
+    __attribute__((visibility("default"))) void* pvalloc(std::size_t size)
+    {
+        return aligned_alloc(4096, (size + 4095) & ~std::size_t{4095});
+    }
+
+    __attribute__((visibility("default"))) std::size_t malloc_usable_size(void* ptr)
+    {
+        return mm::usableSize(ptr);
+    }
+}
+#endif
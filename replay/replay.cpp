@@ -0,0 +1,297 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/mm/heap.hpp>
+#include <dci/mm/stack.hpp>
+#include <dci/mm/trace.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__linux__)
+#   include <unistd.h>
+#endif
+
+/*
+ * воспроизводит трассу, записанную с DCI_MM_TRACE, в одном потоке в порядке времени.
+ * --allocator malloc с LD_PRELOAD позволяет сравнить на той же трассе jemalloc, tcmalloc и т.п.
+ */
+
+namespace
+{
+    using namespace dci::mm;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    struct Live
+    {
+        void*       _ptr;
+        std::size_t _size;
+    };
+
+    enum class Allocator
+    {
+        mm,
+        malloc,
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t residentBytes()
+    {
+#if defined(__linux__)
+        std::FILE* f = std::fopen("/proc/self/statm", "r");
+        if(!f)
+        {
+            return 0;
+        }
+
+        unsigned long size{}, resident{};
+        int got = std::fscanf(f, "%lu %lu", &size, &resident);
+        std::fclose(f);
+        return 2 == got ? resident * static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)) : 0;
+#else
+        return 0;
+#endif
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void touch(void* ptr, std::size_t size)
+    {
+        char* p = static_cast<char*>(ptr);
+        for(std::size_t offset{}; offset < size; offset += 4096)
+        {
+            p[offset] = 1;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void* alloc(Allocator allocator, std::size_t size)
+    {
+        if(Allocator::malloc == allocator)
+        {
+            return std::malloc(size);
+        }
+
+        return size > heap::_sizeClassMax ? heap::alloc(size) : heap::details::allocBySize(size);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void free(Allocator allocator, void* ptr, std::size_t size)
+    {
+        if(Allocator::malloc == allocator)
+        {
+            return std::free(ptr);
+        }
+
+        return size > heap::_sizeClassMax ? heap::free(ptr) : heap::details::freeBySize(ptr, size);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool load(const char* path, std::vector<trace::Record>& records, double& ticksPerSecond)
+    {
+        std::FILE* f = std::fopen(path, "rb");
+        if(!f)
+        {
+            std::perror("fopen");
+            return false;
+        }
+
+        trace::FileHeader header{};
+        if(1 != std::fread(&header, sizeof(header), 1, f) ||
+           std::memcmp(header._magic, trace::_magicValue, sizeof(header._magic)) ||
+           trace::_version != header._version ||
+           sizeof(trace::Record) != header._recordSize)
+        {
+            std::fprintf(stderr, "%s: not a trace or incompatible version\n", path);
+            std::fclose(f);
+            return false;
+        }
+        ticksPerSecond = header._ticksPerSecond;
+
+        trace::Record record;
+        while(1 == std::fread(&record, sizeof(record), 1, f))
+        {
+            records.push_back(record);
+        }
+        std::fclose(f);
+
+        //буферы потоков сбрасываются в файл независимо
+        std::stable_sort(records.begin(), records.end(), [](const trace::Record& a, const trace::Record& b)
+        {
+            return a._ticks < b._ticks;
+        });
+
+        return true;
+    }
+}
+
+/////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+int main(int argc, char* argv[])
+{
+    Allocator allocator{Allocator::mm};
+    const char* path{};
+
+    for(int idx{1}; idx<argc; ++idx)
+    {
+        std::string arg = argv[idx];
+
+        if("--allocator" == arg && idx+1 < argc && !std::strcmp(argv[idx+1], "mm"))
+        {
+            allocator = Allocator::mm;
+            ++idx;
+        }
+        else if("--allocator" == arg && idx+1 < argc && !std::strcmp(argv[idx+1], "malloc"))
+        {
+            allocator = Allocator::malloc;
+            ++idx;
+        }
+        else if(!path && '-' != arg[0])
+        {
+            path = argv[idx];
+        }
+        else
+        {
+            path = nullptr;
+            break;
+        }
+    }
+
+    if(!path)
+    {
+        std::fprintf(stderr, "usage: %s [--allocator mm|malloc] trace-file\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<trace::Record> records;
+    double ticksPerSecond{};
+    if(!load(path, records, ticksPerSecond))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::unordered_map<std::uint64_t, Live> heapLive;
+    std::unordered_map<std::uint64_t, Stack> stackLive;
+    heapLive.reserve(records.size() / 2 + 1);
+
+    std::size_t liveBytes{}, peakLiveBytes{};
+    std::size_t baseResident = residentBytes(), peakResident = baseResident;
+    std::size_t operations{}, unmatched{}, stacksSkipped{};
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+
+    for(const trace::Record& r : records)
+    {
+        switch(r._op)
+        {
+        case trace::Op::alloc:
+            {
+                std::size_t size = std::max<std::size_t>(r._size, 1);
+                auto [iter, inserted] = heapLive.try_emplace(r._ptr, Live{});
+                if(!inserted)
+                {
+                    //освобождение потерялось - место занято прежним объектом
+                    free(allocator, iter->second._ptr, iter->second._size);
+                    liveBytes -= iter->second._size;
+                }
+                iter->second = Live{alloc(allocator, size), size};
+                touch(iter->second._ptr, size);
+                liveBytes += size;
+                peakLiveBytes = std::max(peakLiveBytes, liveBytes);
+            }
+            break;
+
+        case trace::Op::free:
+            {
+                auto iter = heapLive.find(r._ptr);
+                if(heapLive.end() == iter)
+                {
+                    //выделено до начала записи
+                    ++unmatched;
+                    continue;
+                }
+                free(allocator, iter->second._ptr, iter->second._size);
+                liveBytes -= iter->second._size;
+                heapLive.erase(iter);
+            }
+            break;
+
+        case trace::Op::stackAlloc:
+            if(Allocator::malloc == allocator)
+            {
+                ++stacksSkipped;
+                continue;
+            }
+            else
+            {
+                Stack& stack = stackLive[r._ptr];
+                if(!stack.initialized())
+                {
+                    stack::Options options;
+                    options._precommitPages = r._size;
+                    stack.initialize(options);
+                }
+            }
+            break;
+
+        case trace::Op::stackFree:
+            if(Allocator::malloc == allocator)
+            {
+                continue;
+            }
+            if(!stackLive.erase(r._ptr))
+            {
+                ++unmatched;
+                continue;
+            }
+            break;
+
+        default:
+            continue;
+        }
+
+        ++operations;
+        if(!(operations % 4096))
+        {
+            peakResident = std::max(peakResident, residentBytes());
+        }
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    peakResident = std::max(peakResident, residentBytes());
+
+    double traceSeconds = records.empty() || ticksPerSecond <= 0 ? 0 :
+        static_cast<double>(records.back()._ticks - records.front()._ticks) / ticksPerSecond;
+    std::size_t peakResidentDelta = peakResident - baseResident;
+
+    std::printf("records:          %zu (%.3f s recorded)\n", records.size(), traceSeconds);
+    std::printf("operations:       %zu\n", operations);
+    std::printf("unmatched:        %zu\n", unmatched);
+    if(stacksSkipped)
+    {
+        std::printf("stacks skipped:   %zu\n", stacksSkipped);
+    }
+    std::printf("time:             %.6f s, %.2f ns/op, %.0f ops/s\n",
+                seconds,
+                operations ? seconds * 1e9 / static_cast<double>(operations) : 0,
+                seconds > 0 ? static_cast<double>(operations) / seconds : 0);
+    std::printf("peak live:        %zu bytes\n", peakLiveBytes);
+    std::printf("peak resident:    %zu bytes over start\n", peakResidentDelta);
+    std::printf("fragmentation:    %.3f\n", peakLiveBytes ? static_cast<double>(peakResidentDelta) / static_cast<double>(peakLiveBytes) : 0);
+
+    //живые на конец трассы освобождаются, чтобы не мешать сравнению утечками
+    for(auto& [id, live] : heapLive)
+    {
+        free(allocator, live._ptr, live._size);
+    }
+
+    return EXIT_SUCCESS;
+}
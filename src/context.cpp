@@ -0,0 +1,97 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/mm/context.hpp>
+#include <dci/mm/stack.hpp>
+#include "impl/contextSwitch.hpp"
+#include "impl/virtualSpace.hpp"
+#include <dci/utils/dbg.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace dci::mm
+{
+    ////////////////////////////////////////////////////////////////
+    Context::Context(Context&& from)
+        : _stack{std::exchange(from._stack, nullptr)}
+        , _sp{std::exchange(from._sp, nullptr)}
+    {
+    }
+
+    Context::~Context()
+    {
+    }
+
+    Context& Context::operator=(Context&& from)
+    {
+        if(this != &from)
+        {
+            _stack = std::exchange(from._stack, nullptr);
+            _sp = std::exchange(from._sp, nullptr);
+        }
+        return *this;
+    }
+
+    void Context::initialize(Stack& stack, Entry entry, void* arg)
+    {
+        dbgAssert(stack.initialized());
+        dbgAssert(stack.growsDown());
+
+        if(!impl::contextSwitch::supported())
+        {
+            dbgWarn("context switch is not implemented for this platform");
+            std::abort();
+        }
+
+        //рост стека обработается только при стеке обработчика SIGSEGV у исполняющего потока
+        if(!impl::VirtualSpace::prepareThread())
+        {
+            std::fprintf(stderr, "unable to allocate signal stack for thread, no space available\n");
+            std::fflush(stderr);
+            std::abort();
+        }
+
+        _stack = &stack;
+        _sp = impl::contextSwitch::prepare(stack.end(), entry, arg);
+    }
+
+    void Context::switchTo(Context& to)
+    {
+        dbgAssert(to._sp);
+        dbgAssert(this != &to);
+
+        //поток может только возобновлять чужие контексты, не создавая стеков
+        if(!impl::VirtualSpace::prepareThread())
+        {
+            std::fprintf(stderr, "unable to allocate signal stack for thread, no space available\n");
+            std::fflush(stderr);
+            std::abort();
+        }
+
+        void* sp = to._sp;
+        to._sp = nullptr;
+        dciMmContextSwitch(&_sp, sp);
+    }
+
+    Stack* Context::stack() const
+    {
+        return _stack;
+    }
+
+    void* Context::suspendedSp() const
+    {
+        return _sp;
+    }
+
+    void Context::compact()
+    {
+        dbgAssert(_stack && _sp);
+        return _stack->compact(_sp);
+    }
+}
@@ -6,31 +6,100 @@
    You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
 
 #include <dci/mm/heap.hpp>
+#include "impl/heapProfile.hpp"
+#include "impl/heapDebug.hpp"
+#include "impl/heap/sizeClass.hpp"
+#include "impl/system.hpp"
+#include "impl/trace.hpp"
+#include <array>
 #include <cstdlib>
-#include <cstring>
 #include <map>
-
-#include <boost/pool/singleton_pool.hpp>
+#include <utility>
+#include <dci/utils/dbg.hpp>
 
 /*
- * сейчас просто как заглушка
- * варианты:
- *      на штатной куче
- *      на кастомных кучах типа jemalloc, tcmalloc, etc. Даже более, многопоток не нужен - его можно вырезать
- *      на базе списков свободных блоков, boost::pool и подобные
- *      взять старую реализацию на базе магий с виртуальным пространством
+ * классы размеров - на слябах (impl/heap/sizeClass.hpp), свои у каждого потока
+ * произвольный размер - на штатной куче
  */
 
 namespace dci::mm::heap
 {
     void* alloc(std::size_t size)
     {
-        return ::malloc(size);
+        void* ptr = impl::system::malloc(size);
+        impl::heapProfile::onAlloc(ptr, size);
+        impl::trace::onOp(impl::trace::Op::alloc, size, ptr);
+        return ptr;
     }
 
     void free(void* ptr)
     {
-        return ::free(ptr);
+        impl::trace::onOp(impl::trace::Op::free, 0, ptr);
+        impl::heapProfile::onFree(ptr);
+        return impl::system::free(ptr);
+    }
+
+    namespace profile
+    {
+        void start(std::size_t sampleInterval)
+        {
+            return impl::heapProfile::start(sampleInterval);
+        }
+
+        void stop()
+        {
+            return impl::heapProfile::stop();
+        }
+
+        std::string dump()
+        {
+            return impl::heapProfile::dump();
+        }
+    }
+
+    namespace debug
+    {
+        static_assert(static_cast<int>(Poison::none) == static_cast<int>(impl::Poison::none), "incompatible face");
+        static_assert(static_cast<int>(Poison::edges) == static_cast<int>(impl::Poison::edges), "incompatible face");
+        static_assert(static_cast<int>(Poison::sampled) == static_cast<int>(impl::Poison::sampled), "incompatible face");
+        static_assert(static_cast<int>(Poison::full) == static_cast<int>(impl::Poison::full), "incompatible face");
+
+        bool supported()
+        {
+            return impl::Config::_heapDebug;
+        }
+
+        bool setPoison(Poison poison, std::size_t sampling)
+        {
+            if(!impl::Config::_heapDebug)
+            {
+                return false;
+            }
+
+            impl::heapDebug::setPoison(static_cast<impl::Poison>(poison), sampling);
+            return true;
+        }
+
+        Poison poison()
+        {
+            return impl::Config::_heapDebug ? static_cast<Poison>(impl::heapDebug::poison()) : Poison::none;
+        }
+
+        bool setQuarantine(std::size_t objects)
+        {
+            if(!impl::Config::_heapDebug)
+            {
+                return false;
+            }
+
+            impl::heapDebug::setQuarantine(objects);
+            return true;
+        }
+
+        std::size_t quarantine()
+        {
+            return impl::Config::_heapDebug ? impl::heapDebug::quarantine() : 0;
+        }
     }
 
 //    namespace
@@ -76,22 +145,19 @@ namespace dci::mm::heap
 
     namespace details
     {
-        struct Tag;
-        template <std::size_t size>
-        using Pool = boost::singleton_pool<Tag, size, boost::default_user_allocator_new_delete, boost::details::pool::null_mutex, 32, 1024>;
-
         template <std::size_t sizeClass> void* allocBySizeClass()
         {
 //            ++cnts[sizeClass / _sizeClassStep];
 //            incOper();
 
-#ifndef NDEBUG
-            void* ptr = Pool<sizeClass>::malloc();
-            std::memset(ptr, 'A', sizeClass);
+            void* ptr = impl::heap::SizeClass<sizeClass>::alloc();
+            if constexpr(impl::Config::_heapDebug)
+            {
+                impl::heapDebug::onAlloc(ptr, sizeClass);
+            }
+            impl::heapProfile::onAlloc(ptr, sizeClass);
+            impl::trace::onOp(impl::trace::Op::alloc, sizeClass, ptr);
             return ptr;
-#else
-            return Pool<sizeClass>::malloc();
-#endif
         }
 
         template <std::size_t sizeClass> void freeBySizeClass(void* ptr)
@@ -99,10 +165,16 @@ namespace dci::mm::heap
 //            --cnts[sizeClass / _sizeClassStep];
 //            incOper();
 
-#ifndef NDEBUG
-            std::memset(ptr, 'F', sizeClass);
-#endif
-            return Pool<sizeClass>::free(ptr);
+            impl::trace::onOp(impl::trace::Op::free, sizeClass, ptr);
+            impl::heapProfile::onFree(ptr);
+            if constexpr(impl::Config::_heapDebug)
+            {
+                if(impl::heapDebug::onFree(ptr, sizeClass, &impl::heap::SizeClass<sizeClass>::free))
+                {
+                    return;
+                }
+            }
+            return impl::heap::SizeClass<sizeClass>::free(ptr);
         }
     }
 
@@ -149,4 +221,42 @@ namespace dci::mm::heap
     INSTANTIATEONESIZECLASS_x100(0xf00)
 
     INSTANTIATEONESIZECLASS(0x1000)
+
+    ////////////////////////////////////////////////////////////////
+    namespace details
+    {
+        namespace
+        {
+            constexpr std::size_t _classesAmount = _sizeClassMax / _sizeClassStep + 1;
+
+            template <std::size_t... idx>
+            constexpr auto makeAllocTable(std::index_sequence<idx...>)
+            {
+                using Alloc = void*(*)();
+                return std::array<Alloc, sizeof...(idx)>{&allocBySizeClass<idx ? idx*_sizeClassStep : _sizeClassMin>...};
+            }
+
+            template <std::size_t... idx>
+            constexpr auto makeFreeTable(std::index_sequence<idx...>)
+            {
+                using Free = void(*)(void*);
+                return std::array<Free, sizeof...(idx)>{&freeBySizeClass<idx ? idx*_sizeClassStep : _sizeClassMin>...};
+            }
+
+            constexpr auto g_allocTable = makeAllocTable(std::make_index_sequence<_classesAmount>{});
+            constexpr auto g_freeTable = makeFreeTable(std::make_index_sequence<_classesAmount>{});
+        }
+
+        void* allocBySize(std::size_t size)
+        {
+            dbgAssert(size <= _sizeClassMax);
+            return g_allocTable[evalSizeClass(size) / _sizeClassStep]();
+        }
+
+        void freeBySize(void* ptr, std::size_t size)
+        {
+            dbgAssert(size <= _sizeClassMax);
+            return g_freeTable[evalSizeClass(size) / _sizeClassStep](ptr);
+        }
+    }
 }
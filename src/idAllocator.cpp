@@ -0,0 +1,57 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/mm/idAllocator.hpp>
+#include "impl/vm.hpp"
+#include "impl/utils/align.hpp"
+#include "config.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace dci::mm::idAllocator::details
+{
+    void* vmReserve(std::size_t size)
+    {
+        return impl::vm::alloc(impl::utils::alignUp(size, impl::Config::_pageSize));
+    }
+
+    void vmRelease(void* area, std::size_t size)
+    {
+        impl::vm::free(area, impl::utils::alignUp(size, impl::Config::_pageSize));
+    }
+
+    std::size_t vmFit(void* area, std::size_t size, std::size_t committed, std::size_t required)
+    {
+        const std::size_t pageSize = impl::Config::_pageSize;
+
+        //плюс страница запаса вперед, чтобы следующий allocate не вышел за открытую область
+        std::size_t fitted = std::min(impl::utils::alignUp(required, pageSize) + pageSize, impl::utils::alignUp(size, pageSize));
+
+        if(fitted > committed)
+        {
+            if(!impl::vm::protect(static_cast<char *>(area) + committed, fitted - committed, impl::vm::Protection::rw))
+            {
+                dbgWarn("unable to protect region");
+                std::abort();
+            }
+            return fitted;
+        }
+
+        if(fitted + pageSize < committed)
+        {
+            if(!impl::vm::protect(static_cast<char *>(area) + fitted, committed - fitted, impl::vm::Protection::none))
+            {
+                dbgWarn("unable to protect region");
+                std::abort();
+            }
+            return fitted;
+        }
+
+        return committed;
+    }
+}
@@ -0,0 +1,183 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "contextSwitch.hpp"
+#include <dci/utils/dbg.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#if (defined(__x86_64__) || defined(__aarch64__)) && !defined(_WIN32) && defined(__GNUC__)
+#   define DCI_MM_CONTEXT_SWITCH_ASM
+#endif
+
+#ifdef DCI_MM_CONTEXT_SWITCH_ASM
+
+#   if defined(__APPLE__)
+#       define SYMBOL_BEGIN(name) ".globl _" #name "\n .private_extern _" #name "\n .p2align 4\n_" #name ":\n"
+#       define SYMBOL_END(name) "\n"
+#   else
+#       define SYMBOL_BEGIN(name) ".globl " #name "\n .hidden " #name "\n .type " #name ", %function\n .p2align 4\n" #name ":\n"
+#       define SYMBOL_END(name) ".size " #name ", .-" #name "\n"
+#   endif
+
+extern "C" void dciMmContextStart();
+
+#   if defined(__x86_64__)
+/*
+ * кадр от вершины: mxcsr(4) fpucw(2) pad(2) r15 r14 r13 r12 rbx rbp ret
+ * старт: r12 - entry, r13 - arg, r14 - на случай возврата из entry
+ */
+asm(
+    ".text\n"
+    SYMBOL_BEGIN(dciMmContextSwitch)
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    subq $8, %rsp\n"
+    "    stmxcsr (%rsp)\n"
+    "    fnstcw 4(%rsp)\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    ldmxcsr (%rsp)\n"
+    "    fldcw 4(%rsp)\n"
+    "    addq $8, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    SYMBOL_END(dciMmContextSwitch)
+
+    SYMBOL_BEGIN(dciMmContextStart)
+    "    movq %r13, %rdi\n"
+    "    callq *%r12\n"
+    "    callq *%r14\n"
+    "    ud2\n"
+    SYMBOL_END(dciMmContextStart)
+);
+
+#   elif defined(__aarch64__)
+/*
+ * кадр от вершины: d8-d15 x19-x28 x29 x30, 0xb0 байт
+ * старт: x19 - entry, x20 - arg, x21 - на случай возврата из entry
+ */
+asm(
+    ".text\n"
+    SYMBOL_BEGIN(dciMmContextSwitch)
+    "    sub sp, sp, #0xb0\n"
+    "    stp d8,  d9,  [sp, #0x00]\n"
+    "    stp d10, d11, [sp, #0x10]\n"
+    "    stp d12, d13, [sp, #0x20]\n"
+    "    stp d14, d15, [sp, #0x30]\n"
+    "    stp x19, x20, [sp, #0x40]\n"
+    "    stp x21, x22, [sp, #0x50]\n"
+    "    stp x23, x24, [sp, #0x60]\n"
+    "    stp x25, x26, [sp, #0x70]\n"
+    "    stp x27, x28, [sp, #0x80]\n"
+    "    stp x29, x30, [sp, #0x90]\n"
+    "    mov x9, sp\n"
+    "    str x9, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp d8,  d9,  [sp, #0x00]\n"
+    "    ldp d10, d11, [sp, #0x10]\n"
+    "    ldp d12, d13, [sp, #0x20]\n"
+    "    ldp d14, d15, [sp, #0x30]\n"
+    "    ldp x19, x20, [sp, #0x40]\n"
+    "    ldp x21, x22, [sp, #0x50]\n"
+    "    ldp x23, x24, [sp, #0x60]\n"
+    "    ldp x25, x26, [sp, #0x70]\n"
+    "    ldp x27, x28, [sp, #0x80]\n"
+    "    ldp x29, x30, [sp, #0x90]\n"
+    "    add sp, sp, #0xb0\n"
+    "    ret\n"
+    SYMBOL_END(dciMmContextSwitch)
+
+    SYMBOL_BEGIN(dciMmContextStart)
+    "    mov x0, x20\n"
+    "    blr x19\n"
+    "    blr x21\n"
+    "    brk #0\n"
+    SYMBOL_END(dciMmContextStart)
+);
+#   endif
+
+#else
+
+extern "C" void dciMmContextSwitch(void** /*saveSp*/, void* /*loadSp*/)
+{
+    dbgWarn("context switch is not implemented for this platform");
+    std::abort();
+}
+
+#endif
+
+namespace dci::mm::impl::contextSwitch
+{
+    namespace
+    {
+        [[noreturn]] void entryReturned()
+        {
+            fputs("context entry returned\n", stderr);
+            fflush(stderr);
+            std::abort();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool supported()
+    {
+#ifdef DCI_MM_CONTEXT_SWITCH_ASM
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void* prepare(char* stackTop, void (*entry)(void*), void* arg)
+    {
+        std::uintptr_t top = reinterpret_cast<std::uintptr_t>(stackTop) & ~std::uintptr_t{15};
+
+#if defined(DCI_MM_CONTEXT_SWITCH_ASM) && defined(__x86_64__)
+        //ret у верхнего края, после него rsp выровнен на 16 как перед call
+        void** frame = reinterpret_cast<void**>(top) - 8;
+        reinterpret_cast<std::uint32_t*>(frame)[0] = 0x1f80;    //mxcsr по умолчанию
+        reinterpret_cast<std::uint16_t*>(frame)[2] = 0x037f;    //x87 по умолчанию
+        reinterpret_cast<std::uint16_t*>(frame)[3] = 0;
+        frame[1] = nullptr;                                     //r15
+        frame[2] = reinterpret_cast<void*>(&entryReturned);     //r14
+        frame[3] = arg;                                         //r13
+        frame[4] = reinterpret_cast<void*>(entry);              //r12
+        frame[5] = nullptr;                                     //rbx
+        frame[6] = nullptr;                                     //rbp
+        frame[7] = reinterpret_cast<void*>(&dciMmContextStart); //ret
+        return frame;
+#elif defined(DCI_MM_CONTEXT_SWITCH_ASM) && defined(__aarch64__)
+        void** frame = reinterpret_cast<void**>(top - 0xb0);
+        for(std::size_t idx{}; idx < 0xb0/sizeof(void*); ++idx)
+        {
+            frame[idx] = nullptr;
+        }
+        frame[8] = reinterpret_cast<void*>(entry);              //x19
+        frame[9] = arg;                                         //x20
+        frame[10] = reinterpret_cast<void*>(&entryReturned);    //x21
+        frame[19] = reinterpret_cast<void*>(&dciMmContextStart);//x30
+        return frame;
+#else
+        (void)top;
+        (void)entry;
+        (void)arg;
+        return nullptr;
+#endif
+    }
+}
@@ -0,0 +1,23 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+/*
+ * сохранить callee-saved регистры на текущем стеке, вершину в *saveSp, перейти на loadSp и восстановить оттуда.
+ * новый стек готовит contextPrepare так, чтобы первое переключение попало в entry(arg)
+ */
+extern "C" void dciMmContextSwitch(void** saveSp, void* loadSp);
+
+namespace dci::mm::impl::contextSwitch
+{
+    // поддерживается ли переключение на этой платформе
+    bool supported();
+
+    // stackTop - граница стека со стороны дна, возвращает начальную вершину для dciMmContextSwitch
+    void* prepare(char* stackTop, void (*entry)(void*), void* arg);
+}
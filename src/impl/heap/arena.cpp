@@ -0,0 +1,287 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "arena.hpp"
+#include "../vm.hpp"
+#include "../system.hpp"
+#include "../utils/align.hpp"
+#include <dci/mm/heap.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+
+namespace dci::mm::impl::heap::arena
+{
+    namespace
+    {
+        // резерв берется кусками по столько слябов
+        constexpr std::size_t _chunkSlabs = 64;
+
+        //с крупными страницами кусок выровнен и кратен им, чтобы слябы не делили крупную страницу с чужими отображениями
+        constexpr std::size_t _chunkAlignment = HugePages::none == Config::_heapHugePages ? _slabSize : std::max(_slabSize, Config::_hugePageSize);
+        constexpr std::size_t _chunkSize = utils::alignUp(_slabSize * _chunkSlabs, _chunkAlignment);
+
+        struct FreeSlab
+        {
+            FreeSlab*   _next;
+            bool        _purged;
+        };
+
+        //все зарезервированные куски, для census; не освобождаются
+        struct Chunk
+        {
+            Chunk*      _next;
+            char*       _begin;
+        };
+
+        std::mutex  g_mtx;
+        FreeSlab*   g_free {};
+        Chunk*      g_chunks {};
+        char*       g_chunkBegin {};
+        char*       g_chunkEnd {};
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        bool registerChunk(char* begin)
+        {
+            Chunk* chunk = static_cast<Chunk*>(system::malloc(sizeof(Chunk)));
+            if(!chunk)
+            {
+                return false;
+            }
+
+            g_chunks = new(chunk) Chunk{g_chunks, begin};
+            g_chunkBegin = begin;
+            g_chunkEnd = begin + _chunkSize;
+            return true;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        bool reserveChunk()
+        {
+            if constexpr(HugePages::hugetlb == Config::_heapHugePages)
+            {
+                if(char* area = static_cast<char *>(vm::allocHuge(_chunkSize)))
+                {
+                    if(registerChunk(area))
+                    {
+                        return true;
+                    }
+                    vm::free(area, _chunkSize);
+                    return false;
+                }
+            }
+
+            //с запасом на выравнивание, хвосты остаются закрытым резервом
+            char* area = static_cast<char *>(vm::alloc(_chunkSize + _chunkAlignment));
+            if(!area)
+            {
+                return false;
+            }
+
+            std::uintptr_t base = reinterpret_cast<std::uintptr_t>(area);
+            char* begin = area + (utils::alignUp(base, _chunkAlignment) - base);
+
+            if(!vm::protect(begin, _chunkSize, vm::Protection::rw))
+            {
+                vm::free(area, _chunkSize + _chunkAlignment);
+                return false;
+            }
+
+            if constexpr(HugePages::none != Config::_heapHugePages)
+            {
+                //не вышло - работаем на обычных страницах
+                vm::adviseHuge(begin, _chunkSize);
+            }
+
+            if(!registerChunk(begin))
+            {
+                vm::free(area, _chunkSize + _chunkAlignment);
+                return false;
+            }
+
+            return true;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void* acquire()
+    {
+        std::lock_guard lock{g_mtx};
+
+        if(g_free)
+        {
+            FreeSlab* slab = g_free;
+            g_free = slab->_next;
+            return slab;
+        }
+
+        if(g_chunkBegin == g_chunkEnd && !reserveChunk())
+        {
+            return nullptr;
+        }
+
+        void* slab = g_chunkBegin;
+        g_chunkBegin += _slabSize;
+        return slab;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void release(void* slab)
+    {
+#ifndef _WIN32
+        //первая страница несет звено списка свободных.
+        //крупные страницы не отдаются: частичный madvise их дробит, а для hugetlb и вовсе не работает
+        if constexpr(HugePages::none == Config::_heapHugePages)
+        {
+            vm::decommit(static_cast<char *>(slab) + Config::_pageSize, _slabSize - Config::_pageSize, Decommit::free);
+        }
+#endif
+
+        //census читает заголовки без блокировки: отданный после его снимка не должен сойти за живой пустой
+        static_cast<SlabHeader *>(slab)->_capacity.store(0, std::memory_order_relaxed);
+
+        std::lock_guard lock{g_mtx};
+        g_free = new(slab) FreeSlab{g_free, false};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t purge()
+    {
+        std::size_t bytes{};
+
+#ifndef _WIN32
+        if constexpr(HugePages::none == Config::_heapHugePages)
+        {
+            //список забирается целиком, madvise идут без блокировки, потом список возвращается
+            FreeSlab* head;
+            {
+                std::lock_guard lock{g_mtx};
+                head = g_free;
+                g_free = nullptr;
+            }
+
+            if(!head)
+            {
+                return 0;
+            }
+
+            FreeSlab* tail = head;
+            for(FreeSlab* slab = head; slab; slab = slab->_next)
+            {
+                if(!slab->_purged)
+                {
+                    vm::decommit(reinterpret_cast<char *>(slab) + Config::_pageSize, _slabSize - Config::_pageSize, Decommit::dontNeed);
+                    bytes += _slabSize - Config::_pageSize;
+                    slab->_purged = true;
+                }
+                tail = slab;
+            }
+
+            std::lock_guard lock{g_mtx};
+            tail->_next = g_free;
+            g_free = head;
+        }
+#endif
+
+        return bytes;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void census(mm::stats::Heap& res)
+    {
+        /*
+         * под блокировкой снимаются только список кусков и адреса свободных слябов,
+         * заголовки занятых читаются уже без нее - владельцы работают дальше, снимок приблизительный.
+         * заголовок лежит в первой странице, она открыта всегда, даже у отданного системе сляба
+         */
+        Chunk* chunks;
+        char* carvedEnd;
+        void** freed{};
+        std::size_t freeAmount{};
+        {
+            std::lock_guard lock{g_mtx};
+
+            chunks = g_chunks;
+            carvedEnd = g_chunkBegin;
+
+            for(FreeSlab* slab = g_free; slab; slab = slab->_next)
+            {
+                ++freeAmount;
+            }
+
+            if(freeAmount)
+            {
+                freed = static_cast<void**>(system::malloc(sizeof(void*) * freeAmount));
+                if(!freed)
+                {
+                    return;
+                }
+
+                std::size_t idx{};
+                for(FreeSlab* slab = g_free; slab; slab = slab->_next)
+                {
+                    freed[idx++] = slab;
+                    res._freeSlabs++;
+                    res._purgedSlabs += slab->_purged ? 1 : 0;
+                }
+            }
+        }
+
+        std::sort(freed, freed + freeAmount);
+
+        constexpr std::size_t buckets = mm::stats::Heap::_occupancyBuckets;
+
+        for(Chunk* chunk = chunks; chunk; chunk = chunk->_next)
+        {
+            //нарезка идет только в последнем куске, он же голова списка
+            char* end = chunk == chunks ? carvedEnd : chunk->_begin + _chunkSize;
+
+            for(char* area = chunk->_begin; area < end; area += _slabSize)
+            {
+                if(std::binary_search(freed, freed + freeAmount, static_cast<void*>(area)))
+                {
+                    continue;
+                }
+
+                const SlabHeader* slab = reinterpret_cast<const SlabHeader*>(area);
+                std::size_t capacity = slab->_capacity.load(std::memory_order_acquire);
+                std::size_t sizeClass = slab->_sizeClass.load(std::memory_order_relaxed);
+                std::size_t allocated = std::min(slab->_allocated.load(std::memory_order_relaxed), capacity);
+
+                //только что выданный и еще не размеченный или отданный после снимка
+                if(!capacity || sizeClass > mm::heap::_sizeClassMax)
+                {
+                    continue;
+                }
+
+                mm::stats::Heap::SizeClass& cls = res._classes[sizeClass / mm::heap::_sizeClassStep];
+                cls._slabs++;
+                cls._objects += allocated;
+                cls._capacity += capacity;
+                cls._emptySlabs += allocated ? 0 : 1;
+                cls._partialSlabs += allocated && allocated < capacity ? 1 : 0;
+
+                res._occupancy[std::min(allocated * buckets / capacity, buckets - 1)]++;
+                res._usedBytes += allocated * sizeClass;
+            }
+        }
+
+        system::free(freed);
+
+        for(const mm::stats::Heap::SizeClass& cls : res._classes)
+        {
+            res._slabs += cls._slabs;
+            res._emptySlabs += cls._emptySlabs;
+            res._partialSlabs += cls._partialSlabs;
+        }
+
+        //отданные системе держат только страницу со звеном списка, прочие свободные - целиком до MADV_FREE
+        res._committedBytes = (res._slabs + res._freeSlabs - res._purgedSlabs) * _slabSize + res._purgedSlabs * Config::_pageSize;
+        res._wastedBytes = res._committedBytes - std::min(res._usedBytes, res._committedBytes);
+    }
+}
@@ -0,0 +1,52 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "config.hpp"
+#include <dci/mm/stats.hpp>
+#include <atomic>
+#include <cstddef>
+
+namespace dci::mm::impl::heap
+{
+    class Owner;
+
+    /*
+     * начало любого сляба класса размеров. класс и вместимость пишутся при создании, занятость - только владельцем,
+     * arena::release обнуляет вместимость. arena::census читает их из других потоков без остановки владельцев,
+     * отсюда атомарность (без RMW)
+     */
+    struct SlabHeader
+    {
+        SlabHeader*                 _prev;
+        SlabHeader*                 _next;
+        Owner*                      _owner;
+        char*                       _objects;
+        std::atomic<std::size_t>    _allocated;
+        std::atomic<std::size_t>    _sizeClass;
+        std::atomic<std::size_t>    _capacity;
+    };
+}
+
+namespace dci::mm::impl::heap::arena
+{
+    static constexpr std::size_t _slabSize = Config::_heapSlabPages * Config::_pageSize;
+    static_assert(!(_slabSize & (_slabSize-1)), "slab size must be power of 2");
+
+    // открытый на запись сляб, выровненный на _slabSize, из общего для всех классов размеров резерва
+    void* acquire();
+
+    // страницы возвращаются системе, адресное пространство остается в резерве для следующих acquire
+    void release(void* slab);
+
+    // свободные слябы отдаются системе немедленно (release отдает лениво), возвращает объем
+    std::size_t purge();
+
+    // заполненность слябов резерва, приблизительный снимок
+    void census(mm::stats::Heap& res);
+}
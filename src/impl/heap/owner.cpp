@@ -0,0 +1,46 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "owner.hpp"
+
+namespace dci::mm::impl::heap
+{
+    thread_local ThreadOwners t_threadOwners;
+
+    std::atomic<Owner*> Owner::_all {};
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t Owner::trimAll()
+    {
+        std::size_t bytes{};
+        for(Owner* owner = _all.load(std::memory_order_acquire); owner; owner = owner->_nextAll)
+        {
+            bytes += owner->_trim(owner);
+        }
+
+        return bytes;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    ThreadOwners::~ThreadOwners()
+    {
+        while(_head)
+        {
+            Owner* owner = _head;
+            _head = owner->_nextOwned;
+            owner->_nextOwned = nullptr;
+            owner->_abandon(owner);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void ThreadOwners::add(Owner* owner)
+    {
+        owner->_nextOwned = _head;
+        _head = owner;
+    }
+}
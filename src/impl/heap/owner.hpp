@@ -0,0 +1,109 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+namespace dci::mm::impl::heap
+{
+    /*
+     * экземпляр класса размеров, принадлежащий одному потоку.
+     * чужие потоки не трогают его слябы, а складывают освобожденное в _remote (MPSC, связь через сам объект),
+     * владелец забирает накопленное пачкой.
+     * экземпляры не уничтожаются - при завершении потока они уходят в реестр брошенных своего класса
+     * и подбираются следующим потоком вместе со слябами и очередью
+     */
+    class Owner
+    {
+    public:
+        using Abandon = void (*)(Owner*);
+        using Trim = std::size_t (*)(Owner*);
+
+        Owner(Abandon abandon, Trim trim);
+
+        void pushRemote(void* ptr);
+
+        // отдать запасы всех экземпляров всех классов, из любого потока; возвращает объем
+        static std::size_t trimAll();
+
+    protected:
+        bool hasRemote() const;
+        void* takeRemote();
+
+        static void* nextRemote(void* ptr);
+
+    private:
+        friend class ThreadOwners;
+
+        std::atomic<void*>  _remote {};
+        Owner*              _nextOwned {};
+        Abandon             _abandon;
+        Trim                _trim;
+
+        //все когда-либо созданные, экземпляры не уничтожаются
+        Owner*              _nextAll {};
+        static std::atomic<Owner*> _all;
+    };
+
+    ////////////////////////////////////////////////////////////////
+    class ThreadOwners
+    {
+    public:
+        ~ThreadOwners();
+
+        void add(Owner* owner);
+
+    private:
+        Owner* _head {};
+    };
+
+    extern thread_local ThreadOwners t_threadOwners;
+
+    ////////////////////////////////////////////////////////////////
+    inline Owner::Owner(Abandon abandon, Trim trim)
+        : _abandon{abandon}
+        , _trim{trim}
+    {
+        Owner* head = _all.load(std::memory_order_relaxed);
+        do
+        {
+            _nextAll = head;
+        }
+        while(!_all.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    inline void Owner::pushRemote(void* ptr)
+    {
+        void* head = _remote.load(std::memory_order_relaxed);
+        do
+        {
+            *static_cast<void**>(ptr) = head;
+        }
+        while(!_remote.compare_exchange_weak(head, ptr, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    inline bool Owner::hasRemote() const
+    {
+        return _remote.load(std::memory_order_relaxed);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    inline void* Owner::takeRemote()
+    {
+        return _remote.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    inline void* Owner::nextRemote(void* ptr)
+    {
+        return *static_cast<void**>(ptr);
+    }
+}
@@ -0,0 +1,341 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "arena.hpp"
+#include "owner.hpp"
+#include "config.hpp"
+#include "../system.hpp"
+#include "../utils/align.hpp"
+#include <dci/mm/idAllocator.hpp>
+#include <dci/utils/compiler.hpp>
+#include <dci/utils/dbg.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace dci::mm::impl::heap
+{
+    /*
+     * слябы одного класса размеров, выровненные на arena::_slabSize, поэтому сляб объекта находится маской адреса.
+     * в начале сляба заголовок с битовой картой занятости (строки idAllocator::Level по 64 байта), объекты идут после,
+     * со сдвигом на цвет - разные слябы начинают объекты с разных кеш-линий.
+     *
+     * экземпляр у каждого потока свой, сляб помнит владельца, освобождение из чужого потока уходит
+     * в очередь владельца и разбирается им при следующем выделении
+     */
+    template <std::size_t sizeClass>
+    class SizeClass
+        : public Owner
+    {
+    public:
+        static void* alloc();
+        static void free(void* ptr);
+
+    private:
+        SizeClass();
+
+        static SizeClass* acquire();
+        static void abandon(Owner* owner);
+        static std::size_t trim(Owner* owner);
+
+        void* allocLocal();
+        void freeLocal(void* ptr);
+        void drainRemote();
+
+    private:
+        using SlabBase = SlabHeader;
+
+        static constexpr std::size_t _slabSize = arena::_slabSize;
+        static constexpr std::size_t _lineSize = Config::_cacheLineSize;
+
+        //оценка сверху для заголовка, по ней же количество объектов
+        static constexpr std::size_t _metaSize = utils::alignUp(sizeof(SlabBase) + sizeof(idAllocator::Tree<_slabSize / sizeClass>), _lineSize);
+
+    public:
+        static constexpr std::size_t _objectsAmount = (_slabSize - _metaSize) / sizeClass;
+        static constexpr std::size_t _colorsAmount = (_slabSize - _metaSize - _objectsAmount * sizeClass) / _lineSize + 1;
+
+    private:
+        struct Slab : SlabBase
+        {
+            idAllocator::Tree<_objectsAmount> _bitmap;
+        };
+        static_assert(sizeof(Slab) <= _metaSize);
+
+        static Slab* slabOf(void* ptr);
+
+        Slab* makeSlab();
+        void link(Slab* slab);
+        void unlink(Slab* slab);
+
+    private:
+        Slab*               _partial {};//со свободными местами, голова - источник для alloc
+        std::atomic<Slab*>  _spare {};  //один пустой про запас, чтобы не гонять слябы туда-обратно на границе; его может забрать trim из другого потока
+        std::size_t         _nextColor {};
+        SizeClass*          _nextAbandoned {};
+
+        static inline thread_local SizeClass*   t_local {};
+
+        static inline std::mutex                _abandonedMtx;
+        static inline SizeClass*                _abandoned {};
+    };
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void* SizeClass<sizeClass>::alloc()
+    {
+        SizeClass* self = t_local;
+        if(unlikely(!self))
+        {
+            self = acquire();
+            if(!self)
+            {
+                return nullptr;
+            }
+        }
+
+        return self->allocLocal();
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void SizeClass<sizeClass>::free(void* ptr)
+    {
+        Slab* slab = slabOf(ptr);
+        SizeClass* owner = static_cast<SizeClass*>(slab->_owner);
+
+        if(likely(owner == t_local))
+        {
+            return owner->freeLocal(ptr);
+        }
+
+        return owner->pushRemote(ptr);
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    SizeClass<sizeClass>::SizeClass()
+        : Owner{&SizeClass::abandon, &SizeClass::trim}
+    {
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    SizeClass<sizeClass>* SizeClass<sizeClass>::acquire()
+    {
+        SizeClass* self;
+        {
+            std::lock_guard lock{_abandonedMtx};
+            self = _abandoned;
+            if(self)
+            {
+                _abandoned = self->_nextAbandoned;
+                self->_nextAbandoned = nullptr;
+            }
+        }
+
+        if(!self)
+        {
+            void* area = system::malloc(sizeof(SizeClass));
+            if(!area)
+            {
+                return nullptr;
+            }
+            self = new(area) SizeClass;
+        }
+
+        //до регистрации в t_threadOwners, та может сама выделять память
+        t_local = self;
+        t_threadOwners.add(self);
+
+        return self;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void SizeClass<sizeClass>::abandon(Owner* owner)
+    {
+        SizeClass* self = static_cast<SizeClass*>(owner);
+        if(t_local == self)
+        {
+            t_local = nullptr;
+        }
+
+        std::lock_guard lock{_abandonedMtx};
+        self->_nextAbandoned = _abandoned;
+        _abandoned = self;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    std::size_t SizeClass<sizeClass>::trim(Owner* owner)
+    {
+        SizeClass* self = static_cast<SizeClass*>(owner);
+
+        Slab* slab = self->_spare.exchange(nullptr, std::memory_order_acquire);
+        if(!slab)
+        {
+            return 0;
+        }
+
+        arena::release(slab);
+        return _slabSize;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void* SizeClass<sizeClass>::allocLocal()
+    {
+        if(unlikely(hasRemote()))
+        {
+            drainRemote();
+        }
+
+        Slab* slab = _partial;
+        if(unlikely(!slab))
+        {
+            slab = _spare.exchange(nullptr, std::memory_order_acquire);
+            if(!slab)
+            {
+                slab = makeSlab();
+                if(!slab)
+                {
+                    return nullptr;
+                }
+            }
+            link(slab);
+        }
+
+        //наименьший свободный, значит меньше _objectsAmount пока сляб не полон
+        idAllocator::Id id = slab->_bitmap.allocate();
+        dbgAssert(id < _objectsAmount);
+
+        std::size_t allocated = slab->_allocated.load(std::memory_order_relaxed) + 1;
+        slab->_allocated.store(allocated, std::memory_order_relaxed);
+
+        if(_objectsAmount == allocated)
+        {
+            unlink(slab);
+        }
+
+        return slab->_objects + id * sizeClass;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void SizeClass<sizeClass>::freeLocal(void* ptr)
+    {
+        Slab* slab = slabOf(ptr);
+        dbgAssert(slab->_owner == this);
+
+        std::size_t offset = static_cast<std::size_t>(static_cast<char *>(ptr) - slab->_objects);
+        dbgAssert(!(offset % sizeClass));
+        idAllocator::Id id = offset / sizeClass;
+        dbgAssert(id < _objectsAmount && slab->_bitmap.isAllocated(id));
+
+        slab->_bitmap.deallocate(id);
+
+        std::size_t allocated = slab->_allocated.load(std::memory_order_relaxed);
+        slab->_allocated.store(allocated - 1, std::memory_order_relaxed);
+
+        if(_objectsAmount == allocated)
+        {
+            link(slab);
+        }
+
+        if(unlikely(1 == allocated))
+        {
+            unlink(slab);
+
+            Slab* empty = nullptr;
+            if(!_spare.compare_exchange_strong(empty, slab, std::memory_order_release, std::memory_order_relaxed))
+            {
+                arena::release(slab);
+            }
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void SizeClass<sizeClass>::drainRemote()
+    {
+        void* ptr = takeRemote();
+        while(ptr)
+        {
+            void* next = nextRemote(ptr);
+            freeLocal(ptr);
+            ptr = next;
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    typename SizeClass<sizeClass>::Slab* SizeClass<sizeClass>::slabOf(void* ptr)
+    {
+        return reinterpret_cast<Slab*>(reinterpret_cast<std::uintptr_t>(ptr) & ~(_slabSize - 1));
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    typename SizeClass<sizeClass>::Slab* SizeClass<sizeClass>::makeSlab()
+    {
+        void* area = arena::acquire();
+        if(!area)
+        {
+            return nullptr;
+        }
+
+        std::size_t color = _nextColor;
+        _nextColor = (_nextColor + 1) % _colorsAmount;
+
+        Slab* slab = new(area) Slab{};
+        slab->_owner = this;
+        slab->_sizeClass.store(sizeClass, std::memory_order_relaxed);
+        slab->_capacity.store(_objectsAmount, std::memory_order_release);//census видит класс не раньше вместимости
+        slab->_objects = static_cast<char *>(area) + utils::alignUp(sizeof(Slab), _lineSize) + color * _lineSize;
+        dbgAssert(slab->_objects + _objectsAmount * sizeClass <= static_cast<char *>(area) + _slabSize);
+
+        return slab;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void SizeClass<sizeClass>::link(Slab* slab)
+    {
+        slab->_prev = nullptr;
+        slab->_next = _partial;
+        if(_partial)
+        {
+            _partial->_prev = slab;
+        }
+        _partial = slab;
+    }
+
+    ////////////////////////////////////////////////////////////////
+    template <std::size_t sizeClass>
+    void SizeClass<sizeClass>::unlink(Slab* slab)
+    {
+        if(slab->_prev)
+        {
+            slab->_prev->_next = slab->_next;
+        }
+        else
+        {
+            dbgAssert(_partial == slab);
+            _partial = static_cast<Slab*>(slab->_next);
+        }
+
+        if(slab->_next)
+        {
+            slab->_next->_prev = slab->_prev;
+        }
+    }
+}
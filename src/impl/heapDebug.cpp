@@ -0,0 +1,302 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "heapDebug.hpp"
+#include "system.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/*
+ * заливка и карантин объектов классов размеров.
+ * в карантине объект лежит залитым 'F' и еще не возвращен в сляб (значит и в очередь чужого владельца),
+ * поэтому вся залитая область обязана уцелеть до выхода из карантина
+ */
+
+namespace dci::mm::impl::heapDebug
+{
+    std::atomic<bool> g_active {Config::_heapDebug && (Poison::none != Config::_heapPoison || Config::_heapQuarantine)};
+
+    namespace
+    {
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        constexpr std::size_t _edgeSize = 16;
+        constexpr char _allocFill = 'A';
+        constexpr char _freeFill = 'F';
+
+        std::atomic<Poison>         g_poison {Config::_heapPoison};
+        std::atomic<std::size_t>    g_sampling {Config::_heapPoisonSampling};
+        std::atomic<std::size_t>    g_quarantine {Config::_heapQuarantine};
+
+        thread_local std::size_t    t_untilSample {};
+        thread_local bool           t_dead {};
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void updateActive()
+        {
+            g_active.store(Config::_heapDebug &&
+                           (Poison::none != g_poison.load(std::memory_order_relaxed) || g_quarantine.load(std::memory_order_relaxed)),
+                           std::memory_order_relaxed);
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        // что заливать в текущем режиме: none, edges или full
+        Poison effective()
+        {
+            Poison poison = g_poison.load(std::memory_order_relaxed);
+            if(Poison::sampled != poison)
+            {
+                return poison;
+            }
+
+            if(t_untilSample)
+            {
+                --t_untilSample;
+                return Poison::none;
+            }
+
+            t_untilSample = std::max<std::size_t>(g_sampling.load(std::memory_order_relaxed), 1) - 1;
+            return Poison::full;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void fill(void* ptr, std::size_t size, Poison poison, char value)
+        {
+            char* p = static_cast<char *>(ptr);
+
+            if(Poison::full == poison || (Poison::edges == poison && size <= _edgeSize*2))
+            {
+                std::memset(p, value, size);
+            }
+            else if(Poison::edges == poison)
+            {
+                std::memset(p, value, _edgeSize);
+                std::memset(p + size - _edgeSize, value, _edgeSize);
+            }
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        //образец для memcmp, объекты классов размеров не больше его. константный - карантин может работать до динамической инициализации
+        constexpr std::array<char, 4096> g_freePattern = []
+        {
+            std::array<char, 4096> res{};
+            for(char& c : res)
+            {
+                c = _freeFill;
+            }
+            return res;
+        }();
+
+        void verifyRange(const char* p, std::size_t begin, std::size_t end, const void* ptr, std::size_t size)
+        {
+            if(likely(!std::memcmp(p + begin, g_freePattern.data(), end - begin)))
+            {
+                return;
+            }
+
+            std::size_t offset{begin};
+            while(_freeFill == p[offset])
+            {
+                ++offset;
+            }
+
+            std::fprintf(stderr, "heap object %p of size %zu modified after free at offset %zu\n", ptr, size, offset);
+            std::fflush(stderr);
+            std::abort();
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void verify(const void* ptr, std::size_t size, Poison poison)
+        {
+            const char* p = static_cast<const char *>(ptr);
+
+            if(Poison::full == poison || (Poison::edges == poison && size <= _edgeSize*2))
+            {
+                verifyRange(p, 0, size, ptr, size);
+            }
+            else if(Poison::edges == poison)
+            {
+                verifyRange(p, 0, _edgeSize, ptr, size);
+                verifyRange(p, size - _edgeSize, size, ptr, size);
+            }
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        class Quarantine
+        {
+        public:
+            ~Quarantine()
+            {
+                resize(0);
+                t_dead = true;
+            }
+
+            // false - карантин выключен, объект надо освобождать сразу
+            bool push(void* ptr, std::size_t size, Poison poison, Free free)
+            {
+                std::size_t capacity = g_quarantine.load(std::memory_order_relaxed);
+                if(capacity != _capacity)
+                {
+                    resize(capacity);
+                }
+
+                if(!_capacity)
+                {
+                    return false;
+                }
+
+                if(_capacity == _amount)
+                {
+                    evict();
+                }
+
+                _entries[(_head + _amount) % _capacity] = Entry{ptr, size, poison, free};
+                ++_amount;
+                return true;
+            }
+
+        private:
+            struct Entry
+            {
+                void*       _ptr;
+                std::size_t _size;
+                Poison      _poison;
+                Free        _free;
+            };
+
+            void evict()
+            {
+                Entry& entry = _entries[_head];
+                _head = (_head + 1) % _capacity;
+                --_amount;
+
+                verify(entry._ptr, entry._size, entry._poison);
+                entry._free(entry._ptr);
+            }
+
+            void resize(std::size_t capacity)
+            {
+                while(_amount)
+                {
+                    evict();
+                }
+
+                system::free(_entries);
+                _entries = nullptr;
+                _capacity = 0;
+                _head = 0;
+
+                if(capacity)
+                {
+                    _entries = static_cast<Entry*>(system::malloc(sizeof(Entry) * capacity));
+                    if(_entries)
+                    {
+                        _capacity = capacity;
+                    }
+                }
+            }
+
+        private:
+            Entry*      _entries {};
+            std::size_t _capacity {};
+            std::size_t _head {};
+            std::size_t _amount {};
+        };
+
+        thread_local Quarantine t_quarantine;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void poisonAlloc(void* ptr, std::size_t size)
+    {
+        fill(ptr, size, effective(), _allocFill);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool poisonFree(void* ptr, std::size_t size, Free free)
+    {
+        Poison poison = effective();
+        fill(ptr, size, poison, _freeFill);
+
+        if(t_dead || !g_quarantine.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+
+        return t_quarantine.push(ptr, size, poison, free);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void setPoison(Poison poison, std::size_t sampling)
+    {
+        g_sampling.store(sampling, std::memory_order_relaxed);
+        g_poison.store(poison, std::memory_order_relaxed);
+        updateActive();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Poison poison()
+    {
+        return g_poison.load(std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void setQuarantine(std::size_t objects)
+    {
+        //потоки подстраивают свои карантины при следующем освобождении
+        g_quarantine.store(objects, std::memory_order_relaxed);
+        updateActive();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t quarantine()
+    {
+        return g_quarantine.load(std::memory_order_relaxed);
+    }
+
+    namespace
+    {
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        struct EnvSetup
+        {
+            EnvSetup()
+            {
+                if(!Config::_heapDebug)
+                {
+                    return;
+                }
+
+                //DCI_MM_HEAP_POISON=none|edges|sampled[:N]|full
+                if(const char* env = std::getenv("DCI_MM_HEAP_POISON"))
+                {
+                    unsigned long long sampling{Config::_heapPoisonSampling};
+
+                    if(!std::strcmp(env, "none")) setPoison(Poison::none, sampling);
+                    else if(!std::strcmp(env, "edges")) setPoison(Poison::edges, sampling);
+                    else if(!std::strcmp(env, "full")) setPoison(Poison::full, sampling);
+                    else if(!std::strncmp(env, "sampled", 7))
+                    {
+                        std::sscanf(env, "sampled:%llu", &sampling);
+                        setPoison(Poison::sampled, static_cast<std::size_t>(sampling));
+                    }
+                }
+
+                if(const char* env = std::getenv("DCI_MM_HEAP_QUARANTINE"))
+                {
+                    unsigned long long objects{};
+                    if(std::sscanf(env, "%llu", &objects) == 1)
+                    {
+                        setQuarantine(static_cast<std::size_t>(objects));
+                    }
+                }
+            }
+        } g_envSetup;
+    }
+}
@@ -0,0 +1,51 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "config.hpp"
+#include <dci/utils/compiler.hpp>
+#include <atomic>
+#include <cstddef>
+
+namespace dci::mm::impl::heapDebug
+{
+    using Free = void (*)(void*);
+
+    // заливка не none или карантин не пуст, одна проверка на горячем пути
+    extern std::atomic<bool> g_active;
+
+    void poisonAlloc(void* ptr, std::size_t size);
+    bool poisonFree(void* ptr, std::size_t size, Free free);
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void onAlloc(void* ptr, std::size_t size)
+    {
+        if(unlikely(g_active.load(std::memory_order_relaxed)) && ptr)
+        {
+            poisonAlloc(ptr, size);
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // true - объект ушел в карантин, освобождать его сейчас не нужно
+    inline bool onFree(void* ptr, std::size_t size, Free free)
+    {
+        if(unlikely(g_active.load(std::memory_order_relaxed)))
+        {
+            return poisonFree(ptr, size, free);
+        }
+
+        return false;
+    }
+
+    void setPoison(Poison poison, std::size_t sampling);
+    Poison poison();
+
+    void setQuarantine(std::size_t objects);
+    std::size_t quarantine();
+}
@@ -0,0 +1,267 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "heapProfile.hpp"
+
+#include <dci/utils/dbg.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+#   include <windows.h>
+#elif __has_include(<execinfo.h>)
+#   include <execinfo.h>
+#   define DCI_MM_HAVE_EXECINFO 1
+#endif
+
+/*
+ * выборка аллокаций по схеме Пуассона, как в tcmalloc: в среднем одна выборка на sampleInterval байт,
+ * для выбранных объектов сохраняется стек вызова, пока объект жив
+ */
+
+namespace dci::mm::impl::heapProfile
+{
+    std::atomic<bool> g_enabled {};
+    std::atomic<std::size_t> g_liveSamples {};
+
+    thread_local std::ptrdiff_t t_bytesUntilSample {};
+
+    namespace
+    {
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        constexpr std::size_t _maxDepth = 32;
+        constexpr std::size_t _slotsAmount = 1 << 16;
+        constexpr std::size_t _maxProbes = 64;
+
+        void* const _busy = reinterpret_cast<void *>(1);
+        void* const _tomb = reinterpret_cast<void *>(2);
+
+        struct Slot
+        {
+            std::atomic<void*>  _ptr;
+            std::size_t         _size;
+            std::size_t         _depth;
+            void*               _frames[_maxDepth];
+        };
+
+        std::atomic<Slot*>          g_slots {};
+        std::atomic<std::size_t>    g_sampleInterval {};
+        std::mutex                  g_startMtx;
+
+        thread_local std::uint64_t  t_random {};
+        thread_local bool           t_inside {};
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::size_t slotIndex(void* ptr)
+        {
+            std::uint64_t h = reinterpret_cast<std::uintptr_t>(ptr);
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+            return static_cast<std::size_t>(h);
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::ptrdiff_t nextSampleDistance()
+        {
+            if(!t_random)
+            {
+                t_random = reinterpret_cast<std::uintptr_t>(&t_random) | 1;
+            }
+
+            //xorshift64
+            t_random ^= t_random << 13;
+            t_random ^= t_random >> 7;
+            t_random ^= t_random << 17;
+
+            double u = static_cast<double>((t_random >> 11) + 1) / static_cast<double>(1ULL << 53);
+            double distance = -std::log(u) * static_cast<double>(g_sampleInterval.load(std::memory_order_relaxed));
+
+            return static_cast<std::ptrdiff_t>(std::min(distance, 1e15)) + 1;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        std::size_t captureStack(void** frames, std::size_t depth)
+        {
+#if defined(_WIN32)
+            return RtlCaptureStackBackTrace(2, static_cast<DWORD>(depth), frames, nullptr);
+#elif defined(DCI_MM_HAVE_EXECINFO)
+            return static_cast<std::size_t>(::backtrace(frames, static_cast<int>(depth)));
+#else
+            (void)frames;
+            (void)depth;
+            return 0;
+#endif
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void sample(void* ptr, std::size_t size)
+    {
+        //первое обращение потока: интервал еще не разыгран, иначе первое выделение каждого потока попадало бы в выборку
+        if(!t_random)
+        {
+            t_bytesUntilSample += nextSampleDistance();
+            if(t_bytesUntilSample >= 0)
+            {
+                return;
+            }
+        }
+
+        if(t_inside)
+        {
+            t_bytesUntilSample = nextSampleDistance();
+            return;
+        }
+        t_inside = true;
+
+        t_bytesUntilSample = nextSampleDistance();
+
+        Slot* slots = g_slots.load(std::memory_order_acquire);
+        if(slots && ptr)
+        {
+            std::size_t idx = slotIndex(ptr);
+            for(std::size_t probe{}; probe<_maxProbes; ++probe, ++idx)
+            {
+                Slot& slot = slots[idx % _slotsAmount];
+                void* cur = slot._ptr.load(std::memory_order_relaxed);
+                if((nullptr == cur || _tomb == cur) && slot._ptr.compare_exchange_strong(cur, _busy, std::memory_order_acquire))
+                {
+                    slot._size = size;
+                    slot._depth = captureStack(slot._frames, _maxDepth);
+                    slot._ptr.store(ptr, std::memory_order_release);
+                    g_liveSamples.fetch_add(1, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            //таблица переполнена - выборка теряется
+        }
+
+        t_inside = false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void forget(void* ptr)
+    {
+        Slot* slots = g_slots.load(std::memory_order_acquire);
+        if(!slots || !ptr)
+        {
+            return;
+        }
+
+        std::size_t idx = slotIndex(ptr);
+        for(std::size_t probe{}; probe<_maxProbes; ++probe, ++idx)
+        {
+            Slot& slot = slots[idx % _slotsAmount];
+            void* cur = slot._ptr.load(std::memory_order_relaxed);
+            if(nullptr == cur)
+            {
+                return;
+            }
+
+            if(ptr == cur && slot._ptr.compare_exchange_strong(cur, _tomb, std::memory_order_relaxed))
+            {
+                g_liveSamples.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void start(std::size_t sampleInterval)
+    {
+        std::lock_guard lock{g_startMtx};
+
+        if(!g_slots.load(std::memory_order_relaxed))
+        {
+            Slot* slots = static_cast<Slot*>(std::calloc(_slotsAmount, sizeof(Slot)));
+            if(!slots)
+            {
+                dbgWarn("unable to allocate heap profile");
+                return;
+            }
+
+            //первый вызов backtrace может подгружать libgcc и аллоцировать
+            void* frames[_maxDepth];
+            captureStack(frames, _maxDepth);
+
+            g_slots.store(slots, std::memory_order_release);
+        }
+
+        g_sampleInterval.store(std::max(sampleInterval, std::size_t{1}), std::memory_order_relaxed);
+        g_enabled.store(true, std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void stop()
+    {
+        g_enabled.store(false, std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::string dump()
+    {
+        bool inside = t_inside;
+        t_inside = true;
+
+        struct Totals
+        {
+            std::size_t _count {};
+            std::size_t _bytes {};
+        };
+
+        std::map<std::vector<void*>, Totals> byStack;
+        Totals total;
+
+        if(Slot* slots = g_slots.load(std::memory_order_acquire))
+        {
+            for(std::size_t idx{}; idx<_slotsAmount; ++idx)
+            {
+                const Slot& slot = slots[idx];
+                void* cur = slot._ptr.load(std::memory_order_acquire);
+                if(nullptr == cur || _busy == cur || _tomb == cur)
+                {
+                    continue;
+                }
+
+                Totals& totals = byStack[std::vector<void*>(slot._frames, slot._frames + slot._depth)];
+                totals._count++;
+                totals._bytes += slot._size;
+                total._count++;
+                total._bytes += slot._size;
+            }
+        }
+
+        //формат legacy heap profile, понимается pprof
+        std::ostringstream out;
+        out << "heap profile: " << total._count << ": " << total._bytes << " [" << total._count << ": " << total._bytes << "] @ heap_v2/" << g_sampleInterval.load(std::memory_order_relaxed) << "\n";
+        for(const auto& [frames, totals] : byStack)
+        {
+            out << totals._count << ": " << totals._bytes << " [" << totals._count << ": " << totals._bytes << "] @";
+            for(void* frame : frames)
+            {
+                out << " " << frame;
+            }
+            out << "\n";
+        }
+
+        std::ifstream maps{"/proc/self/maps"};
+        if(maps)
+        {
+            out << "\nMAPPED_LIBRARIES:\n" << maps.rdbuf();
+        }
+
+        t_inside = inside;
+        return out.str();
+    }
+}
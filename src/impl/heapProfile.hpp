@@ -0,0 +1,51 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <dci/utils/compiler.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dci::mm::impl::heapProfile
+{
+    extern std::atomic<bool> g_enabled;
+    extern std::atomic<std::size_t> g_liveSamples;
+
+    extern thread_local std::ptrdiff_t t_bytesUntilSample;
+
+    void sample(void* ptr, std::size_t size);
+    void forget(void* ptr);
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void onAlloc(void* ptr, std::size_t size)
+    {
+        if(unlikely(g_enabled.load(std::memory_order_relaxed)))
+        {
+            t_bytesUntilSample -= static_cast<std::ptrdiff_t>(size);
+            if(unlikely(t_bytesUntilSample < 0))
+            {
+                sample(ptr, size);
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void onFree(void* ptr)
+    {
+        if(unlikely(g_liveSamples.load(std::memory_order_relaxed)))
+        {
+            forget(ptr);
+        }
+    }
+
+    void start(std::size_t sampleInterval);
+    void stop();
+    std::string dump();
+}
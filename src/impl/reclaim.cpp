@@ -0,0 +1,236 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "reclaim.hpp"
+#include "heap/owner.hpp"
+#include "heap/arena.hpp"
+#include "virtualSpace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+namespace dci::mm::impl::reclaim
+{
+    namespace
+    {
+        std::atomic<void(*)()>      g_handler {};
+
+        std::mutex                  g_mtx;
+        std::condition_variable     g_cv;
+        std::thread                 g_thread;
+        bool                        g_stop {};
+        bool                        g_atexit {};
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        bool readFile(const std::string& path, char* buf, std::size_t size)
+        {
+            std::FILE* f = std::fopen(path.c_str(), "r");
+            if(!f)
+            {
+                return false;
+            }
+
+            std::size_t got = std::fread(buf, 1, size-1, f);
+            std::fclose(f);
+            buf[got] = 0;
+            return got > 0;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        //some avg10=1.23 avg60=... total=...
+        bool psiSomeAvg10(const std::string& path, double& value)
+        {
+            char buf[512];
+            if(!readFile(path, buf, sizeof(buf)))
+            {
+                return false;
+            }
+
+            const char* pos = std::strstr(buf, "some avg10=");
+            if(!pos)
+            {
+                return false;
+            }
+
+            value = std::strtod(pos + std::strlen("some avg10="), nullptr);
+            return true;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        //число или "max"
+        bool readBytes(const std::string& path, unsigned long long& value)
+        {
+            char buf[64];
+            if(!readFile(path, buf, sizeof(buf)))
+            {
+                return false;
+            }
+
+            return std::sscanf(buf, "%llu", &value) == 1;
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        //cgroup v2: строка "0::/path"
+        std::string ownCgroupDir()
+        {
+            char buf[4096];
+            if(!readFile("/proc/self/cgroup", buf, sizeof(buf)))
+            {
+                return {};
+            }
+
+            const char* line = buf;
+            while(line && *line)
+            {
+                if(!std::strncmp(line, "0::", 3))
+                {
+                    const char* end = std::strchr(line, '\n');
+                    std::string path{line + 3, end ? static_cast<std::size_t>(end - line - 3) : std::strlen(line + 3)};
+                    return "/sys/fs/cgroup" + (path == "/" ? std::string{} : path);
+                }
+
+                line = std::strchr(line, '\n');
+                if(line)
+                {
+                    ++line;
+                }
+            }
+
+            return {};
+        }
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        void stopAtExit()
+        {
+            reclaim::stop();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void start(const mm::reclaim::Options& options)
+    {
+        std::lock_guard lock{g_mtx};
+        if(g_thread.joinable())
+        {
+            return;
+        }
+
+        /*
+         * поток останавливается до разрушения статических объектов: joinable std::thread при разрушении
+         * вызывает std::terminate, а trim работает с аренами и пространствами стеков.
+         * atexit после их создания - значит и отработает раньше их разрушения
+         */
+        if(!g_atexit)
+        {
+            g_atexit = !std::atexit(stopAtExit);
+        }
+
+        g_stop = false;
+        g_thread = std::thread{[options]
+        {
+            std::unique_lock lock{g_mtx};
+            while(!g_stop)
+            {
+                lock.unlock();
+                reclaim::poll(options);
+                lock.lock();
+
+                g_cv.wait_for(lock, std::chrono::milliseconds{options._periodMs}, []{return g_stop;});
+            }
+        }};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void stop()
+    {
+        std::thread thread;
+        {
+            std::lock_guard lock{g_mtx};
+            g_stop = true;
+            thread.swap(g_thread);
+        }
+
+        g_cv.notify_all();
+        if(thread.joinable())
+        {
+            //exit из обработчика давления - сам поток себя не дождется
+            if(thread.get_id() == std::this_thread::get_id())
+            {
+                thread.detach();
+                return;
+            }
+
+            thread.join();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool underPressure(const mm::reclaim::Options& options)
+    {
+        double someAvg10{};
+        if(psiSomeAvg10(options._psiPath, someAvg10) && someAvg10 >= options._someAvg10)
+        {
+            return true;
+        }
+
+        std::string cgroupDir = options._cgroupDir.empty() ? ownCgroupDir() : options._cgroupDir;
+        if(cgroupDir.empty())
+        {
+            return false;
+        }
+
+        //memory.high = max - не задан, давить нечему
+        unsigned long long current{}, high{};
+        if(readBytes(cgroupDir + "/memory.current", current) && readBytes(cgroupDir + "/memory.high", high) && high)
+        {
+            return static_cast<double>(current) >= static_cast<double>(high) * options._highRatio;
+        }
+
+        return false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool poll(const mm::reclaim::Options& options)
+    {
+        if(!underPressure(options))
+        {
+            return false;
+        }
+
+        trim();
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t trim()
+    {
+        //запасные слябы уходят в арену, та отдает системе все свободные разом
+        heap::Owner::trimAll();
+        std::size_t bytes = heap::arena::purge();
+
+        bytes += VirtualSpace::dropWarmAll();
+
+        if(void(*handler)() = g_handler.load(std::memory_order_acquire))
+        {
+            handler();
+        }
+
+        return bytes;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void setPressureHandler(void(* handler)())
+    {
+        g_handler.store(handler, std::memory_order_release);
+    }
+}
@@ -0,0 +1,23 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <dci/mm/reclaim.hpp>
+#include <cstddef>
+
+namespace dci::mm::impl::reclaim
+{
+    void start(const mm::reclaim::Options& options);
+    void stop();
+
+    bool underPressure(const mm::reclaim::Options& options);
+    bool poll(const mm::reclaim::Options& options);
+    std::size_t trim();
+
+    void setPressureHandler(void(*)());
+}
@@ -7,17 +7,21 @@
 
 #include "stack.hpp"
 #include "virtualSpace.hpp"
+#include "trace.hpp"
 
 namespace dci::mm::impl
 {
     Stack::Stack()
-        : _content(nullptr)
+        : _space(nullptr)
+        , _content(nullptr)
     {
     }
 
     Stack::Stack(Stack&& from)
-        : _content(from._content)
+        : _space(from._space)
+        , _content(from._content)
     {
+        from._space = nullptr;
         from._content = nullptr;
     }
 
@@ -25,19 +29,28 @@ namespace dci::mm::impl
     {
         if(_content)
         {
-            VirtualSpace::single().freeStackContent(_content);
+            trace::onOp(trace::Op::stackFree, 0, _content);
+            _space->freeStackContent(_content);
             _content = nullptr;
+            _space = nullptr;
         }
     }
 
     Stack& Stack::operator=(Stack&& from)
     {
+        _space = from._space;
         _content = from._content;
+        from._space = nullptr;
         from._content = nullptr;
         return *this;
     }
 
-    void Stack::initialize()
+    void Stack::initialize(const mm::stack::Options& options)
+    {
+        return initialize(VirtualSpace::single(), options);
+    }
+
+    void Stack::initialize(VirtualSpace& space, const mm::stack::Options& options)
     {
         if(_content)
         {
@@ -45,7 +58,28 @@ namespace dci::mm::impl
             return;
         }
 
-        _content = VirtualSpace::single().allocStackContent();
+        _content = space.allocStackContent(options);
+        _space = &space;
+        trace::onOp(trace::Op::stackAlloc, options._precommitPages, _content);
+    }
+
+    bool Stack::tryInitialize(VirtualSpace& space, const mm::stack::Options& options)
+    {
+        if(_content)
+        {
+            throw "already initialized";
+            return false;
+        }
+
+        _content = space.tryAllocStackContent(options);
+        if(!_content)
+        {
+            return false;
+        }
+
+        _space = &space;
+        trace::onOp(trace::Op::stackAlloc, options._precommitPages, _content);
+        return true;
     }
 
     bool Stack::initialized() const
@@ -86,9 +120,51 @@ namespace dci::mm::impl
         return static_cast<std::size_t>(header._userspaceEnd - header._userspaceBegin);
     }
 
+    std::size_t Stack::committedBytes() const
+    {
+        dbgAssert(initialized());
+        return _content->committedBytes();
+    }
+
+    std::size_t Stack::peakUsage() const
+    {
+        dbgAssert(initialized());
+        return _content->peakBytes();
+    }
+
     void Stack::compact()
     {
         dbgAssert(initialized());
         _content->compact();
     }
+
+    void Stack::compact(void* suspendedSp)
+    {
+        dbgAssert(initialized());
+        _content->compact(static_cast<char*>(suspendedSp));
+    }
+
+    bool Stack::hibernate()
+    {
+        dbgAssert(initialized());
+        return _content->hibernate();
+    }
+
+    void Stack::wake()
+    {
+        dbgAssert(initialized());
+        _content->wake();
+    }
+
+    bool Stack::hibernated() const
+    {
+        dbgAssert(initialized());
+        return _content->hibernated();
+    }
+
+    std::size_t Stack::hibernatedBytes() const
+    {
+        dbgAssert(initialized());
+        return _content->hibernatedBytes();
+    }
 }
@@ -8,9 +8,12 @@
 #pragma once
 #include <cstddef>
 #include "stack/content.hpp"
+#include <dci/mm/stack/options.hpp>
 
 namespace dci::mm::impl
 {
+    class VirtualSpace;
+
     class Stack final
     {
     public:
@@ -20,7 +23,9 @@ namespace dci::mm::impl
 
         Stack& operator=(Stack&& from);
 
-        void initialize();
+        void initialize(const mm::stack::Options& options);
+        void initialize(VirtualSpace& space, const mm::stack::Options& options);
+        bool tryInitialize(VirtualSpace& space, const mm::stack::Options& options);
         bool initialized() const;
 
     public:
@@ -31,9 +36,19 @@ namespace dci::mm::impl
         char* end() const;
         std::size_t size() const;
 
+        std::size_t committedBytes() const;
+        std::size_t peakUsage() const;
+
         void compact();
+        void compact(void* suspendedSp);
+
+        bool hibernate();
+        void wake();
+        bool hibernated() const;
+        std::size_t hibernatedBytes() const;
 
     private:
+        VirtualSpace*   _space;
         stack::Content* _content;
     };
 }
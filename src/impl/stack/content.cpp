@@ -7,24 +7,49 @@
 
 #include "content.hpp"
 
+#include "packer.hpp"
 #include "config.hpp"
+#include <dci/mm/heap/allocable.hpp>
+#include <dci/utils/compiler.hpp>
+#include <algorithm>
 #ifdef HAVE_VALGRIND
 #   include <valgrind.h>
 #endif
 
 namespace dci::mm::impl::stack
 {
-    Content::Content()
-        : Base()
+    namespace
+    {
+        std::size_t precommitBytes(const mm::stack::Options& options)
+        {
+            return std::min(options._precommitPages, Config::_stackPages) * Config::_pageSize;
+        }
+
+        std::size_t growBytes(const mm::stack::Options& options)
+        {
+            return std::clamp(options._growPages, std::size_t{1}, Config::_stackPages) * Config::_pageSize;
+        }
+    }
+
+    Content::Content(const mm::stack::Options& options)
+        : Base(precommitBytes(options), growBytes(options))
     {
-#ifdef HAVE_VALGRIND
         auto& header = Base::header();
+        header._hibernated = false;
+        header._hibernatedBegin = nullptr;
+        header._hibernatedEnd = nullptr;
+        header._hibernatedData = nullptr;
+        header._hibernatedBytes = 0;
+
+#ifdef HAVE_VALGRIND
         header._valgrindId = VALGRIND_STACK_REGISTER(header._userspaceBegin, header._userspaceEnd);
 #endif
     }
 
     Content::~Content()
     {
+        dropHibernatedData();
+
 #ifdef HAVE_VALGRIND
         auto& header = Base::header();
         VALGRIND_STACK_DEREGISTER(header._valgrindId);
@@ -36,4 +61,168 @@ namespace dci::mm::impl::stack
         return Base::header();
     }
 
+    bool Content::fits(const mm::stack::Options& options)
+    {
+        auto& header = Base::header();
+        return header._precommitBytes >= precommitBytes(options) && header._growBytes == growBytes(options);
+    }
+
+    std::size_t Content::committedBytes()
+    {
+        auto& header = Base::header();
+        std::size_t res = static_cast<std::size_t>(_growsDown ?
+                                                       header._userspaceEnd - header._userspaceMapped :
+                                                       header._userspaceMapped - header._userspaceBegin);
+
+        if(header._hibernated)
+        {
+            res -= static_cast<std::size_t>(header._hibernatedEnd - header._hibernatedBegin);
+        }
+
+        return res;
+    }
+
+    std::size_t Content::peakBytes()
+    {
+        auto& header = Base::header();
+        return static_cast<std::size_t>(_growsDown ?
+                                            header._userspaceEnd - header._userspacePeak :
+                                            header._userspacePeak - header._userspaceBegin);
+    }
+
+    void Content::compact(char* onStackPointer)
+    {
+        auto& header = Base::header();
+        dbgAssert(onStackPointer >= header._userspaceBegin && onStackPointer <= header._userspaceEnd);
+
+        //спящему нечего отдавать, все и так у системы
+        if(header._hibernated)
+        {
+            return;
+        }
+
+        return Base::compact(onStackPointer);
+    }
+
+    bool Content::hibernate()
+    {
+        auto& header = Base::header();
+        if(header._hibernated)
+        {
+            return true;
+        }
+
+        dropHibernatedData();
+
+        //только целые страницы, частичная под заголовком/у начала остается как есть
+        std::uintptr_t begin, end;
+        if(_growsDown)
+        {
+            begin = reinterpret_cast<std::uintptr_t>(header._userspaceMapped);
+            end = reinterpret_cast<std::uintptr_t>(header._userspaceEnd) / Config::_pageSize * Config::_pageSize;
+        }
+        else
+        {
+            begin = (reinterpret_cast<std::uintptr_t>(header._userspaceBegin) + Config::_pageSize - 1) / Config::_pageSize * Config::_pageSize;
+            end = reinterpret_cast<std::uintptr_t>(header._userspaceMapped);
+        }
+
+        if(begin >= end)
+        {
+            return false;
+        }
+
+        const std::uint64_t* words = reinterpret_cast<const std::uint64_t*>(begin);
+        std::size_t wordsAmount = (end - begin) / sizeof(std::uint64_t);
+
+        std::size_t bytes = packer::pack(words, wordsAmount, nullptr);
+        std::uint8_t* data = static_cast<std::uint8_t*>(heap::details::allocable::alloc(bytes));
+        if(!data)
+        {
+            //без образа страницы отдавать нельзя - содержимое живого стека пропадет
+            return false;
+        }
+        packer::pack(words, wordsAmount, data);
+
+        {
+            vm::Batch batch;
+            if(!batch.protect(reinterpret_cast<void*>(begin), end - begin, vm::Protection::none) ||
+               !batch.decommit(reinterpret_cast<void*>(begin), end - begin, Decommit::dontNeed))
+            {
+                dbgWarn("unable to protect region");
+                std::abort();
+            }
+        }
+
+        header._hibernatedBegin = reinterpret_cast<char*>(begin);
+        header._hibernatedEnd = reinterpret_cast<char*>(end);
+        header._hibernatedData = data;
+        header._hibernatedBytes = bytes;
+        header._hibernated = true;
+
+        return true;
+    }
+
+    void Content::wake()
+    {
+        auto& header = Base::header();
+        if(header._hibernated)
+        {
+            unpack();
+        }
+
+        dropHibernatedData();
+    }
+
+    bool Content::hibernated()
+    {
+        return Base::header()._hibernated;
+    }
+
+    std::size_t Content::hibernatedBytes()
+    {
+        auto& header = Base::header();
+        return header._hibernated ? header._hibernatedBytes : 0;
+    }
+
+    bool Content::vmAccessHandler(std::uintptr_t offset)
+    {
+        if(unlikely(Base::header()._hibernated))
+        {
+            unpack();
+        }
+
+        return Base::vmAccessHandler(offset);
+    }
+
+    void Content::unpack()
+    {
+        auto& header = Base::header();
+        dbgAssert(header._hibernated);
+
+        std::size_t size = static_cast<std::size_t>(header._hibernatedEnd - header._hibernatedBegin);
+
+        {
+            vm::Batch batch;
+            if(!batch.protect(header._hibernatedBegin, size, vm::Protection::rw))
+            {
+                dbgWarn("unable to protect region");
+                std::abort();
+            }
+        }
+
+        packer::unpack(header._hibernatedData, header._hibernatedBytes, reinterpret_cast<std::uint64_t*>(header._hibernatedBegin), size / sizeof(std::uint64_t));
+        header._hibernated = false;
+    }
+
+    void Content::dropHibernatedData()
+    {
+        auto& header = Base::header();
+        if(header._hibernatedData)
+        {
+            heap::details::allocable::free(header._hibernatedData, header._hibernatedBytes);
+            header._hibernatedData = nullptr;
+            header._hibernatedBytes = 0;
+        }
+    }
 }
@@ -8,19 +8,43 @@
 #pragma once
 #include "layout.hpp"
 #include "config.hpp"
+#include <dci/mm/stack/options.hpp>
+#include <cstdint>
 
 namespace dci::mm::impl::stack
 {
     class Content
         : public Layout<Config::_stackGrowsDown, Config::_stackHasGuard>
     {
-        using Base = Layout<true, true>;
+        using Base = Layout<Config::_stackGrowsDown, Config::_stackHasGuard>;
 
     public:
-        Content();
+        Content(const mm::stack::Options& options);
         ~Content();
 
     public:
         const Header& header();
+
+        // построенный ранее годится для запроса с такими опциями
+        bool fits(const mm::stack::Options& options);
+
+        std::size_t committedBytes();
+        std::size_t peakBytes();
+
+        using Base::compact;
+        void compact(char* onStackPointer);
+
+    public:
+        // сжать открытые страницы в кучу и отдать их системе; стек не должен исполняться
+        bool hibernate();
+        void wake();
+        bool hibernated();
+        std::size_t hibernatedBytes();
+
+        bool vmAccessHandler(std::uintptr_t offset);
+
+    private:
+        void unpack();
+        void dropHibernatedData();
     };
 }
@@ -8,6 +8,8 @@
 #pragma once
 
 #include "config.hpp"
+#include <cstddef>
+#include <cstdint>
 
 namespace dci::mm::impl::stack
 {
@@ -15,8 +17,20 @@ namespace dci::mm::impl::stack
     {
         char* _userspaceBegin;
         char* _userspaceMapped;
+        char* _userspacePeak;
         char* _userspaceEnd;
 
+        std::size_t _precommitBytes;
+        std::size_t _growBytes;
+
+        //спящий: страницы [_hibernatedBegin, _hibernatedEnd) сжаты в _hibernatedData и отданы системе
+        //после пробуждения из обработчика сигнала _hibernatedData еще занята, освобождается при следующем hibernate/wake/разрушении
+        bool _hibernated;
+        char* _hibernatedBegin;
+        char* _hibernatedEnd;
+        std::uint8_t* _hibernatedData;
+        std::size_t _hibernatedBytes;
+
 #ifdef HAVE_VALGRIND
         unsigned _valgrindId;
 #endif
@@ -43,37 +43,58 @@ namespace dci::mm::impl::stack
         static constexpr bool _hasGuard = false;
 
     public:
-        Layout()
+        Layout(std::size_t precommitBytes, std::size_t growBytes)
         {
+            vm::Batch batch;
             char* area = reinterpret_cast<char *>(this);
-            char* mappedEnd = extend(area, area + std::min(sizeof(Layout), sizeof(_headerArea) + Config::_stackKeepProtectedBytes));
+            char* mappedEnd = extend(batch, area, area + std::min(sizeof(Layout), sizeof(_headerArea) + std::max(Config::_stackKeepProtectedBytes, precommitBytes)));
+            if(!batch.flush())
+            {
+                dbgWarn("unable to protect region");
+                std::abort();
+            }
+
+            if(precommitBytes && !vm::populate(area, static_cast<std::size_t>(mappedEnd - area)))
+            {
+                dbgWarn("unable to populate region");
+            }
 
             new (&header()) Header;
 
             header()._userspaceBegin = area + offsetof(Layout, _userArea);
             header()._userspaceMapped = mappedEnd;
+            header()._userspacePeak = mappedEnd;
             header()._userspaceEnd = area + offsetof(Layout, _userArea) + sizeof(UserArea);
+            header()._precommitBytes = precommitBytes;
+            header()._growBytes = growBytes;
         }
 
         ~Layout()
         {
+            vm::Batch batch;
             char* area = reinterpret_cast<char *>(this);
             char* mappedEnd = header()._userspaceMapped;
 
             header().~Header();
 
-            reduce(mappedEnd, area);
+            reduce(batch, mappedEnd, area);
         }
 
         void compact()
         {
-            char* bound = header()._userspaceMapped;
 #ifdef _WIN32
-            char* onStackPointer = static_cast<char*>(_malloca(1));
+            return compact(static_cast<char*>(_malloca(1)));
 #else
-            char* onStackPointer = static_cast<char*>(alloca(1));
+            return compact(static_cast<char*>(alloca(1)));
 #endif
-            bound = reduce(bound, std::min(reinterpret_cast<char*>(this), onStackPointer + Config::_stackKeepProtectedBytes));
+        }
+
+        void compact(char* onStackPointer)
+        {
+            vm::Batch batch;
+            char* bound = header()._userspaceMapped;
+            char* precommitted = reinterpret_cast<char*>(this) + std::min(sizeof(*this), sizeof(_headerArea) + header()._precommitBytes);
+            bound = reduce(batch, bound, std::max(precommitted, std::min(reinterpret_cast<char*>(this) + sizeof(*this), onStackPointer + Config::_stackKeepProtectedBytes)));
             if(bound != header()._userspaceMapped)
             {
                 header()._userspaceMapped = bound;
@@ -82,18 +103,23 @@ namespace dci::mm::impl::stack
 
         bool vmAccessHandler(std::uintptr_t offset)
         {
+            vm::Batch batch;
             char* bound = header()._userspaceMapped;
-            bound = extend(bound, reinterpret_cast<char *>(this) + offset);
+            bound = extend(batch, bound, reinterpret_cast<char *>(this) + std::min(sizeof(*this), offset + header()._growBytes - Config::_pageSize));
             if(bound != header()._userspaceMapped)
             {
                 header()._userspaceMapped = bound;
+
+                //пик - по странице отказа, а не по границе открытого с запасом _growBytes
+                char* reached = reinterpret_cast<char *>(this) + std::min(sizeof(*this), (offset / Config::_pageSize + 1) * Config::_pageSize);
+                header()._userspacePeak = std::max(header()._userspacePeak, std::min(reached, bound));
             }
 
             return true;
         }
 
     private:
-        char* reduce(char* oldBound, char* newBound)
+        char* reduce(vm::Batch& batch, char* oldBound, char* newBound)
         {
             dbgAssert(oldBound >= reinterpret_cast<char *>(this) && oldBound <= reinterpret_cast<char *>(this) + sizeof(*this));
             dbgAssert(newBound >= reinterpret_cast<char *>(this) && newBound <= reinterpret_cast<char *>(this) + sizeof(*this));
@@ -116,7 +142,7 @@ namespace dci::mm::impl::stack
             char* limit = static_cast<char*>(static_cast<void*>(&_userArea)) + sizeof(_userArea);
             if(oldBound + Config::_pageSize <= limit)
             {
-                if(!vm::protect(
+                if(!batch.protect(
                             newBound + Config::_pageSize,
                             static_cast<std::size_t>(oldBound - newBound),
                             vm::Protection::none))
@@ -127,7 +153,7 @@ namespace dci::mm::impl::stack
             }
             else
             {
-                if(!vm::protect(
+                if(!batch.protect(
                             newBound + Config::_pageSize,
                             static_cast<std::size_t>(oldBound - newBound - Config::_pageSize),
                             vm::Protection::none))
@@ -137,7 +163,7 @@ namespace dci::mm::impl::stack
                 }
             }
 
-            if(!vm::protect(
+            if(!batch.protect(
                         newBound,
                         Config::_pageSize,
                         vm::Protection::guard))
@@ -147,10 +173,14 @@ namespace dci::mm::impl::stack
             }
 
 #else
-            if(!vm::protect(
+            if(!batch.protect(
                         newBound,
                         static_cast<std::size_t>(oldBound - newBound),
-                        vm::Protection::none))
+                        vm::Protection::none) ||
+               !batch.decommit(
+                        newBound,
+                        static_cast<std::size_t>(oldBound - newBound),
+                        Config::_stackDecommit))
             {
                 dbgWarn("unable to protect region");
                 std::abort();
@@ -160,7 +190,7 @@ namespace dci::mm::impl::stack
             return newBound;
         }
 
-        char* extend(char* oldBound, char* newBound)
+        char* extend(vm::Batch& batch, char* oldBound, char* newBound)
         {
             dbgAssert(oldBound >= reinterpret_cast<char *>(this));
             dbgAssert(oldBound <= reinterpret_cast<char *>(this) + sizeof(*this));
@@ -185,7 +215,7 @@ namespace dci::mm::impl::stack
             char* limit = static_cast<char*>(static_cast<void*>(&_userArea)) + sizeof(_userArea);
             if(newBound + Config::_pageSize <= limit)
             {
-                if(!vm::protect(
+                if(!batch.protect(
                             newBound,
                             Config::_pageSize,
                             vm::Protection::guard))
@@ -196,7 +226,7 @@ namespace dci::mm::impl::stack
             }
 #endif
 
-            if(!vm::protect(
+            if(!batch.protect(
                         oldBound,
                         static_cast<std::size_t>(newBound - oldBound),
                         vm::Protection::rw))
@@ -239,7 +269,8 @@ namespace dci::mm::impl::stack
         static constexpr bool _hasGuard = true;
 
     public:
-        Layout()
+        Layout(std::size_t precommitBytes, std::size_t growBytes)
+            : _withoutGuard{precommitBytes, growBytes}
         {
             (void)_guardArea;
         }
@@ -253,6 +284,11 @@ namespace dci::mm::impl::stack
             return _withoutGuard.compact();
         }
 
+        void compact(char* onStackPointer)
+        {
+            return _withoutGuard.compact(onStackPointer);
+        }
+
         bool vmAccessHandler(std::uintptr_t offset)
         {
             if(offset >= offsetof(Layout, _guardArea))
@@ -290,32 +326,54 @@ namespace dci::mm::impl::stack
         static constexpr bool _hasGuard = false;
 
     public:
-        Layout()
+        Layout(std::size_t precommitBytes, std::size_t growBytes)
         {
+            vm::Batch batch;
             char* area = reinterpret_cast<char *>(this);
-            char* mappedEnd = extend(area + sizeof(Layout), area + sizeof(Layout) - std::min(sizeof(Layout), sizeof(_headerArea) + Config::_stackKeepProtectedBytes));
+            char* mappedEnd = extend(batch, area + sizeof(Layout), area + sizeof(Layout) - std::min(sizeof(Layout), sizeof(_headerArea) + std::max(Config::_stackKeepProtectedBytes, precommitBytes)));
+            if(!batch.flush())
+            {
+                dbgWarn("unable to protect region");
+                std::abort();
+            }
+
+            if(precommitBytes && !vm::populate(mappedEnd, static_cast<std::size_t>(area + sizeof(Layout) - mappedEnd)))
+            {
+                dbgWarn("unable to populate region");
+            }
 
             new (&header()) Header;
 
             header()._userspaceBegin = area + offsetof(Layout, _userArea);
             header()._userspaceMapped = mappedEnd;
+            header()._userspacePeak = mappedEnd;
             header()._userspaceEnd = area + offsetof(Layout, _userArea) + sizeof(UserArea);
+            header()._precommitBytes = precommitBytes;
+            header()._growBytes = growBytes;
         }
 
         ~Layout()
         {
+            vm::Batch batch;
             char* area = reinterpret_cast<char *>(this);
             char* mappedEnd = header()._userspaceMapped;
 
             header().~Header();
 
-            reduce(mappedEnd, area + sizeof(Layout));
+            reduce(batch, mappedEnd, area + sizeof(Layout));
         }
 
         void compact()
         {
+            return compact(static_cast<char*>(alloca(1)));
+        }
+
+        void compact(char* onStackPointer)
+        {
+            vm::Batch batch;
             char* bound = header()._userspaceMapped;
-            bound = reduce(bound, std::max(reinterpret_cast<char*>(this), static_cast<char*>(alloca(1)) - Config::_stackKeepProtectedBytes));
+            char* precommitted = reinterpret_cast<char*>(this) + sizeof(*this) - std::min(sizeof(*this), sizeof(_headerArea) + header()._precommitBytes);
+            bound = reduce(batch, bound, std::min(precommitted, std::max(reinterpret_cast<char*>(this), onStackPointer - Config::_stackKeepProtectedBytes)));
             if(bound != header()._userspaceMapped)
             {
                 header()._userspaceMapped = bound;
@@ -324,18 +382,24 @@ namespace dci::mm::impl::stack
 
         bool vmAccessHandler(std::uintptr_t offset)
         {
+            vm::Batch batch;
             char* bound = header()._userspaceMapped;
-            bound = extend(bound, reinterpret_cast<char *>(this) + offset);
+            std::uintptr_t growBytes = header()._growBytes - Config::_pageSize;
+            bound = extend(batch, bound, reinterpret_cast<char *>(this) + (offset > growBytes ? offset - growBytes : 0));
             if(bound != header()._userspaceMapped)
             {
                 header()._userspaceMapped = bound;
+
+                //пик - по странице отказа, а не по границе открытого с запасом _growBytes
+                char* reached = reinterpret_cast<char *>(this) + offset / Config::_pageSize * Config::_pageSize;
+                header()._userspacePeak = std::min(header()._userspacePeak, std::max(reached, bound));
             }
 
             return true;
         }
 
     private:
-        char* reduce(char* oldBound, char* newBound)
+        char* reduce(vm::Batch& batch, char* oldBound, char* newBound)
         {
             dbgAssert(oldBound >= reinterpret_cast<char *>(this));
             dbgAssert(oldBound <= reinterpret_cast<char *>(this) + sizeof(*this));
@@ -360,7 +424,7 @@ namespace dci::mm::impl::stack
             char* limit = static_cast<char*>(static_cast<void*>(&_userArea));
             if(oldBound - Config::_pageSize >= limit)
             {
-                if(!vm::protect(
+                if(!batch.protect(
                             oldBound-Config::_pageSize,
                             static_cast<std::size_t>(newBound - oldBound),
                             vm::Protection::none))
@@ -371,7 +435,7 @@ namespace dci::mm::impl::stack
             }
             else
             {
-                if(!vm::protect(
+                if(!batch.protect(
                             oldBound,
                             static_cast<std::size_t>(newBound - oldBound - Config::_pageSize),
                             vm::Protection::none))
@@ -381,7 +445,7 @@ namespace dci::mm::impl::stack
                 }
             }
 
-            if(!vm::protect(
+            if(!batch.protect(
                         newBound-Config::_pageSize,
                         Config::_pageSize,
                         vm::Protection::guard))
@@ -390,10 +454,14 @@ namespace dci::mm::impl::stack
                 std::abort();
             }
 #else
-            if(!vm::protect(
+            if(!batch.protect(
+                        oldBound,
+                        static_cast<std::size_t>(newBound - oldBound),
+                        vm::Protection::none) ||
+               !batch.decommit(
                         oldBound,
                         static_cast<std::size_t>(newBound - oldBound),
-                        vm::Protection::none))
+                        Config::_stackDecommit))
             {
                 dbgWarn("unable to protect region");
                 std::abort();
@@ -403,7 +471,7 @@ namespace dci::mm::impl::stack
             return newBound;
         }
 
-        char* extend(char* oldBound, char* newBound)
+        char* extend(vm::Batch& batch, char* oldBound, char* newBound)
         {
             dbgAssert(oldBound >= reinterpret_cast<char *>(this));
             dbgAssert(oldBound <= reinterpret_cast<char *>(this) + sizeof(*this));
@@ -428,7 +496,7 @@ namespace dci::mm::impl::stack
             char* limit = static_cast<char*>(static_cast<void*>(&_userArea));
             if(newBound - Config::_pageSize >= limit)
             {
-                if(!vm::protect(
+                if(!batch.protect(
                             newBound - Config::_pageSize,
                             Config::_pageSize,
                             vm::Protection::guard))
@@ -439,7 +507,7 @@ namespace dci::mm::impl::stack
             }
 #endif
 
-            if(!vm::protect(
+            if(!batch.protect(
                         newBound,
                         static_cast<std::size_t>(oldBound - newBound),
                         vm::Protection::rw))
@@ -482,7 +550,8 @@ namespace dci::mm::impl::stack
         static constexpr bool _hasGuard = true;
 
     public:
-        Layout()
+        Layout(std::size_t precommitBytes, std::size_t growBytes)
+            : _withoutGuard{precommitBytes, growBytes}
         {
             (void)_guardArea;
         }
@@ -496,6 +565,11 @@ namespace dci::mm::impl::stack
             return _withoutGuard.compact();
         }
 
+        void compact(char* onStackPointer)
+        {
+            return _withoutGuard.compact(onStackPointer);
+        }
+
         bool vmAccessHandler(std::uintptr_t offset)
         {
             if(offset <= offsetof(Layout, _withoutGuard))
@@ -0,0 +1,92 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "packer.hpp"
+#include <dci/utils/dbg.hpp>
+#include <cstring>
+#include <limits>
+
+namespace dci::mm::impl::stack::packer
+{
+    namespace
+    {
+        struct Token
+        {
+            std::uint16_t _zeros;
+            std::uint16_t _literals;
+        };
+
+        constexpr std::size_t _runMax = std::numeric_limits<std::uint16_t>::max();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t pack(const std::uint64_t* src, std::size_t words, std::uint8_t* dst)
+    {
+        std::size_t bytes{};
+        std::size_t pos{};
+
+        while(pos < words)
+        {
+            Token token{};
+
+            while(pos < words && !src[pos] && token._zeros < _runMax)
+            {
+                ++token._zeros;
+                ++pos;
+            }
+
+            const std::uint64_t* literals = src + pos;
+            while(pos < words && token._literals < _runMax)
+            {
+                //одиночный ноль посреди литералов дешевле оставить литералом, чем начинать новую лексему
+                if(!src[pos] && (pos+1 >= words || !src[pos+1]))
+                {
+                    break;
+                }
+
+                ++token._literals;
+                ++pos;
+            }
+
+            if(dst)
+            {
+                std::memcpy(dst + bytes, &token, sizeof(token));
+                std::memcpy(dst + bytes + sizeof(token), literals, token._literals * sizeof(std::uint64_t));
+            }
+
+            bytes += sizeof(token) + token._literals * sizeof(std::uint64_t);
+        }
+
+        return bytes;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void unpack(const std::uint8_t* src, std::size_t bytes, std::uint64_t* dst, std::size_t words)
+    {
+        const std::uint8_t* end = src + bytes;
+        std::uint64_t* dstEnd = dst + words;
+        (void)dstEnd;
+
+        while(src < end)
+        {
+            Token token;
+            std::memcpy(&token, src, sizeof(token));
+            src += sizeof(token);
+
+            dbgAssert(dst + token._zeros + token._literals <= dstEnd);
+
+            std::memset(dst, 0, token._zeros * sizeof(std::uint64_t));
+            dst += token._zeros;
+
+            std::memcpy(dst, src, token._literals * sizeof(std::uint64_t));
+            dst += token._literals;
+            src += token._literals * sizeof(std::uint64_t);
+        }
+
+        dbgAssert(dst == dstEnd);
+    }
+}
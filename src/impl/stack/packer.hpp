@@ -0,0 +1,23 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dci::mm::impl::stack::packer
+{
+    /*
+     * простейшее сжатие для спящих стеков: 8-байтные слова, серии нулевых и серии остальных (литералов).
+     * без выделений памяти и без внешних вызовов кроме memcpy/memset - распаковка идет прямо из обработчика сигнала
+     */
+
+    // dst == nullptr - только посчитать размер
+    std::size_t pack(const std::uint64_t* src, std::size_t words, std::uint8_t* dst);
+    void unpack(const std::uint8_t* src, std::size_t bytes, std::uint64_t* dst, std::size_t words);
+}
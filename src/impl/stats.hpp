@@ -0,0 +1,88 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "config.hpp"
+#include <dci/mm/stats.hpp>
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#   include <x86intrin.h>
+#else
+#   include <chrono>
+#endif
+
+#ifdef HAVE_USDT
+#   include <sys/sdt.h>
+#   define DCI_MM_PROBE2(name, a1, a2) DTRACE_PROBE2(dci_mm, name, a1, a2)
+#   define DCI_MM_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(dci_mm, name, a1, a2, a3)
+#else
+#   define DCI_MM_PROBE2(name, a1, a2)
+#   define DCI_MM_PROBE3(name, a1, a2, a3)
+#endif
+
+namespace dci::mm::impl::stats
+{
+    using Ticks = std::uint64_t;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline Ticks ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        Ticks res;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(res));
+        return res;
+#else
+        return static_cast<Ticks>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    // lock-free, пригодно для вызова из обработчика сигнала
+    class Histogram
+    {
+    public:
+        void add(Ticks value)
+        {
+            std::size_t bucket = 63 - static_cast<std::size_t>(__builtin_clzll(value | 1));
+            _buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+            _amount.fetch_add(1, std::memory_order_relaxed);
+            _sumTicks.fetch_add(value, std::memory_order_relaxed);
+        }
+
+        void read(mm::stats::Histogram& to) const
+        {
+            for(std::size_t idx{}; idx<mm::stats::Histogram::_bucketsAmount; ++idx)
+            {
+                to._buckets[idx] = _buckets[idx].load(std::memory_order_relaxed);
+            }
+            to._amount = _amount.load(std::memory_order_relaxed);
+            to._sumTicks = _sumTicks.load(std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic<std::uint64_t> _buckets[mm::stats::Histogram::_bucketsAmount] {};
+        std::atomic<std::uint64_t> _amount {};
+        std::atomic<std::uint64_t> _sumTicks {};
+    };
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    struct Vm
+    {
+        Histogram                   _handledFaults;
+        std::atomic<std::uint64_t>  _unhandledFaults {};
+
+        Histogram                   _protects;
+        std::atomic<std::uint64_t>  _failedProtects {};
+    };
+
+    extern Vm g_vm;
+}
@@ -0,0 +1,41 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__GLIBC__)
+extern "C" void* __libc_malloc(std::size_t size);
+extern "C" void __libc_free(void* ptr);
+#endif
+
+namespace dci::mm::impl::system
+{
+    /*
+     * штатная куча в обход возможной подмены malloc (mm-malloc-preload),
+     * чтобы крупные объекты не возвращались рекурсивно в себя же
+     */
+    inline void* malloc(std::size_t size)
+    {
+#if defined(__GLIBC__)
+        return ::__libc_malloc(size);
+#else
+        return std::malloc(size);
+#endif
+    }
+
+    inline void free(void* ptr)
+    {
+#if defined(__GLIBC__)
+        return ::__libc_free(ptr);
+#else
+        return std::free(ptr);
+#endif
+    }
+}
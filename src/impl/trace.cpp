@@ -0,0 +1,248 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "trace.hpp"
+
+#ifdef HAVE_TRACE
+#   include "stats.hpp"
+#   include "system.hpp"
+#   include <dci/utils/dbg.hpp>
+#   include <cstdio>
+#   include <cstdlib>
+#   include <cstring>
+#   include <mutex>
+#endif
+
+/*
+ * у каждого потока свой буфер записей, полный буфер целиком уходит в файл под мьютексом файла.
+ * порядок захвата: список буферов, буфер, файл
+ */
+
+namespace dci::mm::impl::trace
+{
+#ifdef HAVE_TRACE
+    std::atomic<bool> g_enabled {};
+
+    namespace
+    {
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        constexpr std::size_t _bufferRecords = 4096;
+
+        struct Buffer;
+
+        std::mutex                      g_buffersMtx;
+        Buffer*                         g_buffers {};
+        std::atomic<std::uint16_t>      g_threads {};
+
+        std::mutex                      g_fileMtx;
+        std::FILE*                      g_file {};
+
+        thread_local bool               t_inside {};
+        thread_local bool               t_dead {};
+
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        struct Buffer
+        {
+            std::atomic_flag    _busy = ATOMIC_FLAG_INIT;
+            mm::trace::Record*  _records {};
+            std::size_t         _amount {};
+            std::uint16_t       _thread {};
+            Buffer*             _prev {};
+            Buffer*             _next {};
+
+            Buffer()
+            {
+                _records = static_cast<mm::trace::Record*>(system::malloc(sizeof(mm::trace::Record) * _bufferRecords));
+                _thread = g_threads.fetch_add(1, std::memory_order_relaxed);
+
+                std::lock_guard lock{g_buffersMtx};
+                _next = g_buffers;
+                if(_next) _next->_prev = this;
+                g_buffers = this;
+            }
+
+            ~Buffer()
+            {
+                {
+                    std::lock_guard lock{g_buffersMtx};
+                    if(_prev) _prev->_next = _next;
+                    else g_buffers = _next;
+                    if(_next) _next->_prev = _prev;
+                }
+
+                lock();
+                flush();
+                system::free(_records);
+                _records = nullptr;
+                unlock();
+
+                t_dead = true;
+            }
+
+            void lock()
+            {
+                while(_busy.test_and_set(std::memory_order_acquire))
+                {
+                }
+            }
+
+            void unlock()
+            {
+                _busy.clear(std::memory_order_release);
+            }
+
+            // под блокировкой буфера
+            void flush()
+            {
+                if(!_amount)
+                {
+                    return;
+                }
+
+                {
+                    std::lock_guard lock{g_fileMtx};
+                    if(g_file)
+                    {
+                        std::fwrite(_records, sizeof(mm::trace::Record), _amount, g_file);
+                    }
+                }
+
+                _amount = 0;
+            }
+        };
+
+        thread_local Buffer t_buffer;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void record(Op op, std::size_t size, const void* ptr)
+    {
+        if(t_inside || t_dead)
+        {
+            return;
+        }
+        t_inside = true;
+
+        Buffer& buffer = t_buffer;
+        buffer.lock();
+
+        if(likely(buffer._records))
+        {
+            mm::trace::Record& r = buffer._records[buffer._amount];
+            r._ticks = stats::ticks();
+            r._ptr = reinterpret_cast<std::uintptr_t>(ptr);
+            r._size = static_cast<std::uint32_t>(size);
+            r._thread = buffer._thread;
+            r._op = op;
+            r._reserved = 0;
+
+            if(_bufferRecords == ++buffer._amount)
+            {
+                buffer.flush();
+            }
+        }
+
+        buffer.unlock();
+        t_inside = false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool start(const char* path)
+    {
+        bool inside = t_inside;
+        t_inside = true;
+
+        std::lock_guard lock{g_fileMtx};
+        if(g_file)
+        {
+            t_inside = inside;
+            return false;
+        }
+
+        g_file = std::fopen(path, "wb");
+        if(!g_file)
+        {
+            dbgWarn("unable to open trace file");
+            t_inside = inside;
+            return false;
+        }
+
+        mm::trace::FileHeader header{};
+        std::memcpy(header._magic, mm::trace::_magicValue, sizeof(header._magic));
+        header._version = mm::trace::_version;
+        header._recordSize = sizeof(mm::trace::Record);
+        header._ticksPerSecond = mm::stats::ticksPerSecond();
+        std::fwrite(&header, sizeof(header), 1, g_file);
+
+        g_enabled.store(true, std::memory_order_relaxed);
+
+        t_inside = inside;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void stop()
+    {
+        bool inside = t_inside;
+        t_inside = true;
+
+        g_enabled.store(false, std::memory_order_relaxed);
+
+        {
+            std::lock_guard lock{g_buffersMtx};
+            for(Buffer* buffer = g_buffers; buffer; buffer = buffer->_next)
+            {
+                buffer->lock();
+                buffer->flush();
+                buffer->unlock();
+            }
+        }
+
+        {
+            std::lock_guard lock{g_fileMtx};
+            if(g_file)
+            {
+                std::fclose(g_file);
+                g_file = nullptr;
+            }
+        }
+
+        t_inside = inside;
+    }
+
+    namespace
+    {
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        struct EnvStarter
+        {
+            EnvStarter()
+            {
+                if(const char* path = std::getenv("DCI_MM_TRACE"))
+                {
+                    start(path);
+                }
+            }
+
+            ~EnvStarter()
+            {
+                stop();
+            }
+        } g_envStarter;
+    }
+#else
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool start(const char*)
+    {
+        return false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void stop()
+    {
+    }
+#endif
+}
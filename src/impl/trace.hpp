@@ -0,0 +1,41 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#pragma once
+
+#include "config.hpp"
+#include <dci/mm/trace.hpp>
+#include <dci/utils/compiler.hpp>
+#include <atomic>
+#include <cstddef>
+
+namespace dci::mm::impl::trace
+{
+    using Op = mm::trace::Op;
+
+#ifdef HAVE_TRACE
+    extern std::atomic<bool> g_enabled;
+
+    void record(Op op, std::size_t size, const void* ptr);
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    inline void onOp(Op op, std::size_t size, const void* ptr)
+    {
+        if(unlikely(g_enabled.load(std::memory_order_relaxed)))
+        {
+            record(op, size, ptr);
+        }
+    }
+#else
+    inline void onOp(Op, std::size_t, const void*)
+    {
+    }
+#endif
+
+    bool start(const char* path);
+    void stop();
+}
@@ -7,85 +7,244 @@
 
 #include "virtualSpace.hpp"
 #include "vm.hpp"
+#include "system.hpp"
 
 #include "stack/content.hpp"
 #include "utils/sized_cast.ipp"
 #include "utils/align.hpp"
-#include "bitIndex.ipp"
-#include "bitIndex/level.ipp"
 
 #include <new>
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
 #include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <utility>
+
+#ifndef _WIN32
+#   include <pthread.h>
+#endif
 
 namespace dci::mm::impl
 {
     namespace
     {
+        /*
+         * все живые пространства, обработчик SIGSEGV и fork перебирают их без блокировок.
+         * первым всегда регистрируется основное (single)
+         */
+        constexpr std::size_t _spacesMax = 64;
+        std::atomic<VirtualSpace*> g_spaces[_spacesMax] {};
+
+        //перебирающие g_spaces сейчас, уничтожаемое пространство после снятия с регистрации ждет их ухода
+        std::atomic<std::size_t> g_spacesVisitors {};
+
+        template <class F>
+        void forEachSpace(F&& f)
+        {
+            g_spacesVisitors.fetch_add(1);
+            for(std::atomic<VirtualSpace*>& slot : g_spaces)
+            {
+                if(VirtualSpace* space = slot.load(std::memory_order_acquire))
+                {
+                    f(*space);
+                }
+            }
+            g_spacesVisitors.fetch_sub(1, std::memory_order_release);
+        }
+
         bool g_vmAccessHandler(void* addr)
         {
-            return VirtualSpace::single().vmAccessHandler(addr);
+            bool handled = false;
+
+            g_spacesVisitors.fetch_add(1);
+            for(std::atomic<VirtualSpace*>& slot : g_spaces)
+            {
+                VirtualSpace* space = slot.load(std::memory_order_acquire);
+                if(space && space->vmAccessHandler(addr))
+                {
+                    handled = true;
+                    break;
+                }
+            }
+            g_spacesVisitors.fetch_sub(1, std::memory_order_release);
+
+            return handled;
         }
         void g_vmPanic(int signum)
         {
             return VirtualSpace::single().vmPanic(signum);
         }
-    }
 
-    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    VirtualSpace::VirtualSpace()
-    {
-        _vm = vm::alloc(_vmSize);
+#ifndef _WIN32
+        /*
+         * захваченные в prepare отпускаются в parent/child по тому же списку, даже если их уже сняли с регистрации,
+         * а уничтожение ждет, пока fork не закончится
+         */
+        thread_local VirtualSpace* t_forkSpaces[_spacesMax] {};
 
-        if(!_vm)
+        void g_forkPrepare()
         {
-            std::fprintf(stderr, "unable to allocate vm\n");
-            std::fflush(stderr);
-            std::abort();
+            g_spacesVisitors.fetch_add(1);
+            for(std::size_t idx{}; idx<_spacesMax; ++idx)
+            {
+                t_forkSpaces[idx] = g_spaces[idx].load(std::memory_order_acquire);
+                if(t_forkSpaces[idx])
+                {
+                    t_forkSpaces[idx]->forkPrepare();
+                }
+            }
         }
 
-        std::size_t addr = utils::sized_cast<std::size_t>(_vm);
+        template <class F>
+        void forEachForkSpace(F&& f)
+        {
+            for(VirtualSpace*& space : t_forkSpaces)
+            {
+                if(space)
+                {
+                    f(*std::exchange(space, nullptr));
+                }
+            }
+            g_spacesVisitors.fetch_sub(1, std::memory_order_release);
+        }
 
-        addr = utils::alignUp(addr, Config::_pageSize);
-        _stacksBitIndex = new(utils::sized_cast<void *>(addr)) StacksBitIndex;
-        addr += _stacksBitIndexAlignedSize;
+        void g_forkParent()
+        {
+            return forEachForkSpace([](VirtualSpace& space){space.forkParent();});
+        }
+        void g_forkChild()
+        {
+            return forEachForkSpace([](VirtualSpace& space){space.forkChild();});
+        }
+#endif
+    }
 
-        addr = utils::alignUp(addr, Config::_stackPages*Config::_pageSize);
-        _stacks = utils::sized_cast<void *>(addr);
-        //addr += _stacksAlignedSize;
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    VirtualSpace::VirtualSpace(std::size_t limit)
+    {
+        setLimit(limit);
 
-        if(!vm::init(g_vmAccessHandler, g_vmPanic))
+        for(std::atomic<VirtualSpace*>& slot : g_spaces)
         {
-            std::fprintf(stderr, "unable to initialize vm\n");
-            std::fflush(stderr);
-            std::abort();
+            VirtualSpace* expected = nullptr;
+            if(slot.compare_exchange_strong(expected, this, std::memory_order_acq_rel))
+            {
+                return;
+            }
         }
+
+        throw std::length_error{"too many stack spaces"};
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     VirtualSpace::~VirtualSpace()
     {
-        if(_stacksBitIndex)
+        dbgAssert(!_allocatedStacks.load(std::memory_order_relaxed));
+
+        //построитель готовых стеков еще может работать - остановить, а построенное разобрать
+        if(_warmBuilder.joinable())
+        {
+            _warmStop.store(true, std::memory_order_relaxed);
+            _warmBuilder.join();
+        }
+        dropWarm();
+
+        for(std::atomic<VirtualSpace*>& slot : g_spaces)
+        {
+            VirtualSpace* expected = this;
+            if(slot.compare_exchange_strong(expected, nullptr))
+            {
+                break;
+            }
+        }
+
+        //обработчик SIGSEGV или fork другого потока мог взять пространство до снятия с регистрации
+        while(g_spacesVisitors.load())
         {
-            _stacksBitIndex->~BitIndex();
-            _stacksBitIndex = nullptr;
+            std::this_thread::yield();
         }
-        _stacks = nullptr;
+        dbgAssert(!_indexReaders.load(std::memory_order_relaxed));
 
-        dbgAssert(_vm);
-        vm::free(_vm, _vmSize);
-        _vm = nullptr;
+        for(void* chunk : _chunks)
+        {
+            vm::free(chunk, _chunkVmSize);
+        }
+        _chunks.clear();
 
-        vm::deinit(&g_vmAccessHandler);
+        const ChunksIndex* index = _chunksIndex.exchange(nullptr);
+        if(index)
+        {
+            const_cast<ChunksIndex*>(index)->_retired = _retiredIndices;
+            _retiredIndices = index;
+        }
+        freeRetiredIndices();
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     namespace
     {
+        //процессное: обработчик SIGSEGV и fork, ставится вместе с основным пространством
+        void setupProcess()
+        {
+            if(!vm::init(g_vmAccessHandler, g_vmPanic))
+            {
+                std::fprintf(stderr, "unable to initialize vm\n");
+                std::fflush(stderr);
+                std::abort();
+            }
+
+#ifndef _WIN32
+            if(pthread_atfork(g_forkPrepare, g_forkParent, g_forkChild))
+            {
+                std::fprintf(stderr, "unable to register fork handlers\n");
+                std::fflush(stderr);
+                std::abort();
+            }
+#endif
+        }
+
+        std::size_t primaryLimit()
+        {
+            if(const char* env = std::getenv("DCI_MM_STACK_LIMIT"))
+            {
+                unsigned long long limit{};
+                if(std::sscanf(env, "%llu", &limit) == 1)
+                {
+                    return static_cast<std::size_t>(limit);
+                }
+            }
+
+            return Config::_stacksAmount;
+        }
+
+        void primaryWarm(VirtualSpace& virtualSpace)
+        {
+            //DCI_MM_STACK_WARM=count[:pages] перекрывает конфигурацию
+            std::size_t warmCount = Config::_stackWarmAmount;
+            std::size_t warmPages = Config::_stackWarmPages;
+            if(const char* env = std::getenv("DCI_MM_STACK_WARM"))
+            {
+                unsigned long long count{}, pages{warmPages};
+                if(std::sscanf(env, "%llu:%llu", &count, &pages) >= 1)
+                {
+                    warmCount = static_cast<std::size_t>(count);
+                    warmPages = static_cast<std::size_t>(pages);
+                }
+            }
+
+            if(warmCount)
+            {
+                virtualSpace.warm(warmCount, warmPages);
+            }
+        }
+
         union VirtualSpaceArea
         {
             char _area{};
             VirtualSpace _virtualSpace;
-            VirtualSpaceArea() : _virtualSpace{} {}
+            VirtualSpaceArea() : _virtualSpace{primaryLimit()} {setupProcess(); primaryWarm(_virtualSpace);}
             ~VirtualSpaceArea() {}
         } g_virtualSpaceArea{};
     }
@@ -97,11 +256,76 @@ namespace dci::mm::impl
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    stack::Content* VirtualSpace::allocStackContent()
+    static_assert(Config::_vmAltStackPages && Config::_vmAltStackPages < Config::_stackPages);
+
+    //стек обработчика SIGSEGV потока - обычный стек из того же пространства, открытый целиком сразу; в allocatedStacks не входит
+    struct VirtualSpace::AltStack
     {
-        bitIndex::Address stackBitAddr = _stacksBitIndex->allocate();
+        bool            _prepared {};
+        stack::Content* _content {};
 
-        if(bitIndex::_badAddress == stackBitAddr)
+        ~AltStack()
+        {
+            if(_content)
+            {
+#ifndef _WIN32
+                vm::altStackReset();
+#endif
+                VirtualSpace& space = VirtualSpace::single();
+                space.destroyStackContent(_content);
+                space._altStacks.fetch_sub(1, std::memory_order_relaxed);
+                _content = nullptr;
+            }
+        }
+    };
+
+    thread_local VirtualSpace::AltStack VirtualSpace::t_altStack;
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool VirtualSpace::prepareThread()
+    {
+#ifndef _WIN32
+        if(likely(t_altStack._prepared))
+        {
+            return true;
+        }
+
+        //в потомке fork поток продолжает работать на нем же; вне предела, гистограммы и allocatedStacks
+        VirtualSpace& space = single();
+        mm::stack::Options options{Config::_vmAltStackPages, 1, true};
+        stack::Content* stackContent = space.createStackContent(options, false);
+
+        if(!stackContent)
+        {
+            //идентификаторы исчерпаны - попытка повторится при следующем обращении
+            return false;
+        }
+
+        t_altStack._prepared = true;
+
+        const stack::Header& header = stackContent->header();
+        char* begin = stack::Content::_growsDown ? header._userspaceMapped : header._userspaceBegin;
+        char* end = stack::Content::_growsDown ? header._userspaceEnd : header._userspaceMapped;
+
+        if(!vm::altStackSet(begin, static_cast<std::size_t>(end - begin)))
+        {
+            //уже стоит чужой, обработчик отработает на нем
+            space.destroyStackContent(stackContent);
+            space._altStacks.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        t_altStack._content = stackContent;
+#endif
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    stack::Content* VirtualSpace::allocStackContent(const mm::stack::Options& options)
+    {
+        stack::Content* stackContent = tryAllocStackContent(options);
+
+        if(!stackContent)
         {
             dbgWarn("no more stacks available");
 
@@ -110,9 +334,72 @@ namespace dci::mm::impl
             std::abort();
         }
 
-        stack::Content* stackContent = utils::sized_cast<stack::Content *>(_stacks) + stackBitAddr;
+        return stackContent;
+    }
 
-        new(stackContent) stack::Content;
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    stack::Content* VirtualSpace::tryAllocStackContent(const mm::stack::Options& options)
+    {
+        //без стека обработчика SIGSEGV рост стека в этом потоке не обработать
+        if(!prepareThread())
+        {
+            return nullptr;
+        }
+
+        if(!options._inheritOnFork && _warmAmount.load(std::memory_order_relaxed))
+        {
+            if(stack::Content* stackContent = takeWarm(options))
+            {
+                _peakPagesHistogram[peakPages(stackContent)].fetch_add(1, std::memory_order_relaxed);
+                _allocatedStacks.fetch_add(1, std::memory_order_relaxed);
+                return stackContent;
+            }
+        }
+
+        stack::Content* stackContent = createStackContent(options, true);
+
+        if(!stackContent)
+        {
+            return nullptr;
+        }
+
+        _peakPagesHistogram[peakPages(stackContent)].fetch_add(1, std::memory_order_relaxed);
+        _allocatedStacks.fetch_add(1, std::memory_order_relaxed);
+
+        return stackContent;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    stack::Content* VirtualSpace::createStackContent(const mm::stack::Options& options, bool limited)
+    {
+        std::unique_lock lock{_stacksMtx};
+
+        idAllocator::Id stackId = allocStackId(limited);
+
+        if(StacksIds::_badId == stackId)
+        {
+            return nullptr;
+        }
+
+        if(!limited)
+        {
+            _altStacks.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        stack::Content* stackContent = VirtualSpace::stackContent(stackId);
+
+        if(options._inheritOnFork)
+        {
+            _inherited.push_back(stackId);
+            if(Config::_stackForkWipe)
+            {
+                vm::forkInclude(stackContent, _stackSize);
+            }
+        }
+
+        lock.unlock();
+
+        new(stackContent) stack::Content{options};
 
         return stackContent;
     }
@@ -120,12 +407,158 @@ namespace dci::mm::impl
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void VirtualSpace::freeStackContent(stack::Content* stackContent)
     {
-        bitIndex::Address stackBitAddr = static_cast<bitIndex::Address>(stackContent - utils::sized_cast<stack::Content *>(_stacks));
+        //гистограмма - по живым стекам
+        _peakPagesHistogram[peakPages(stackContent)].fetch_sub(1, std::memory_order_relaxed);
+        _allocatedStacks.fetch_sub(1, std::memory_order_relaxed);
+        return destroyStackContent(stackContent);
+    }
 
-        dbgAssert(_stacksBitIndex->isAllocated(stackBitAddr));
-        _stacksBitIndex->deallocate(stackBitAddr);
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::destroyStackContent(stack::Content* stackContent)
+    {
+        idAllocator::Id stackId{};
+        bool located = locate(stackContent, stackId);
+        dbgAssert(located);
+        (void)located;
 
+        //сначала разобрать, потом отдать идентификатор - иначе другой поток может уже строить на этом месте
         stackContent->~Content();
+
+        std::lock_guard lock{_stacksMtx};
+
+        dbgAssert(_stacksIds.isAllocated(stackId));
+        _stacksIds.deallocate(stackId);
+
+        if(unlikely(!_inherited.empty()))
+        {
+            auto iter = std::find(_inherited.begin(), _inherited.end(), stackId);
+            if(_inherited.end() != iter)
+            {
+                _inherited.erase(iter);
+                if(Config::_stackForkWipe)
+                {
+                    vm::forkExclude(stackContent, _stackSize);
+                }
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::warm(std::size_t count, std::size_t pagesEach)
+    {
+        std::lock_guard builderLock{_warmBuilderMtx};
+
+        //предыдущий построитель доделывает свое
+        if(_warmBuilder.joinable())
+        {
+            _warmBuilder.join();
+        }
+
+        //идентификаторы - здесь, дорогая часть (mprotect и заполнение страниц) - в фоне
+        std::vector<stack::Content*> slots;
+        slots.reserve(count);
+
+        std::unique_lock lock{_stacksMtx};
+        for(std::size_t idx{}; idx<count; ++idx)
+        {
+            idAllocator::Id stackId = allocStackId();
+            if(StacksIds::_badId == stackId)
+            {
+                dbgWarn("no more stacks available for warm");
+                break;
+            }
+
+            slots.push_back(stackContent(stackId));
+        }
+
+        lock.unlock();
+
+        if(slots.empty())
+        {
+            return;
+        }
+
+        _warmBuilder = std::thread{[this, slots=std::move(slots), pagesEach]
+        {
+            mm::stack::Options options{pagesEach, 1};
+            for(std::size_t idx{}; idx<slots.size(); ++idx)
+            {
+                if(_warmStop.load(std::memory_order_relaxed))
+                {
+                    //пространство уничтожается - не построенные отдать
+                    std::lock_guard lock{_stacksMtx};
+                    for(; idx<slots.size(); ++idx)
+                    {
+                        idAllocator::Id stackId{};
+                        bool located = locate(slots[idx], stackId);
+                        dbgAssert(located);
+                        (void)located;
+                        _stacksIds.deallocate(stackId);
+                    }
+                    break;
+                }
+
+                new(slots[idx]) stack::Content{options};
+
+                std::lock_guard lock{_warmMtx};
+                _warm.push_back(slots[idx]);
+                _warmAmount.fetch_add(1, std::memory_order_relaxed);
+            }
+        }};
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t VirtualSpace::warmAmount() const
+    {
+        return _warmAmount.load(std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    stack::Content* VirtualSpace::takeWarm(const mm::stack::Options& options)
+    {
+        std::lock_guard lock{_warmMtx};
+
+        for(std::size_t idx{_warm.size()}; idx; --idx)
+        {
+            stack::Content* stackContent = _warm[idx-1];
+            if(stackContent->fits(options))
+            {
+                _warm[idx-1] = _warm.back();
+                _warm.pop_back();
+                _warmAmount.fetch_sub(1, std::memory_order_relaxed);
+                return stackContent;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t VirtualSpace::dropWarm()
+    {
+        std::vector<stack::Content*> warm;
+        {
+            std::lock_guard lock{_warmMtx};
+            warm.swap(_warm);
+            _warmAmount.store(0, std::memory_order_relaxed);
+        }
+
+        std::size_t bytes{};
+        for(stack::Content* stackContent : warm)
+        {
+            bytes += stackContent->committedBytes();
+            destroyStackContent(stackContent);
+        }
+
+        return bytes;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t VirtualSpace::dropWarmAll()
+    {
+        std::size_t bytes{};
+        forEachSpace([&](VirtualSpace& space){bytes += space.dropWarm();});
+        return bytes;
     }
 
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
@@ -137,12 +570,11 @@ namespace dci::mm::impl
     /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     bool VirtualSpace::vmAccessHandler(void* ptr)
     {
-
-        if(likely(utils::sized_cast<std::uintptr_t>(ptr) - utils::sized_cast<std::uintptr_t>(_stacks) < _stacksAlignedSize))
+        idAllocator::Id stackId;
+        if(likely(locate(ptr, stackId)))
         {
-            bitIndex::Address stackBitAddr = static_cast<bitIndex::Address>(static_cast<std::size_t>(utils::sized_cast<char *>(ptr) - utils::sized_cast<char *>(_stacks)) / _stackSize);
-            dbgAssert(_stacksBitIndex->isAllocated(stackBitAddr));
-            (void)stackBitAddr;
+            dbgAssert(_stacksIds.isAllocated(stackId));
+            (void)stackId;
 
             void* stackContentPtr = utils::sized_cast<void *>(utils::sized_cast<std::uintptr_t>(ptr) / _stackSize * _stackSize);
 
@@ -150,12 +582,23 @@ namespace dci::mm::impl
 
             std::uintptr_t offset = utils::sized_cast<std::uintptr_t>(ptr) - utils::sized_cast<std::uintptr_t>(stackContent);
 
-            return stackContent->vmAccessHandler(offset);
+            std::size_t peakPagesBefore = peakPages(stackContent);
+            bool res = stackContent->vmAccessHandler(offset);
+            std::size_t peakPagesAfter = peakPages(stackContent);
+
+            if(peakPagesAfter != peakPagesBefore)
+            {
+                _peakPagesHistogram[peakPagesBefore].fetch_sub(1, std::memory_order_relaxed);
+                _peakPagesHistogram[peakPagesAfter].fetch_add(1, std::memory_order_relaxed);
+            }
+
+            return res;
         }
 
         return false;
     }
 
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
     void VirtualSpace::vmPanic(int signum)
     {
         if(_panic)
@@ -163,4 +606,330 @@ namespace dci::mm::impl
             return _panic(signum);
         }
     }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::forkPrepare()
+    {
+        //ни фоновое построение, ни другие потоки не должны оставить потомку захваченные мьютексы
+        _warmBuilderMtx.lock();
+        _stacksMtx.lock();
+        _warmMtx.lock();
+
+        //fork из сопрограммы: стек, на котором работает поток, нужен потомку целиком, даже не наследуемый
+        char sp;
+        idAllocator::Id stackId{};
+        if(Config::_stackForkWipe && locate(&sp, stackId) && _stacksIds.isAllocated(stackId) &&
+           _inherited.end() == std::find(_inherited.begin(), _inherited.end(), stackId))
+        {
+            if(vm::forkInclude(stackContent(stackId), _stackSize))
+            {
+                _forkStack = stackId;
+            }
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::forkParent()
+    {
+        if(StacksIds::_badId != _forkStack)
+        {
+            vm::forkExclude(stackContent(_forkStack), _stackSize);
+            _forkStack = StacksIds::_badId;
+        }
+
+        _warmMtx.unlock();
+        _stacksMtx.unlock();
+        _warmBuilderMtx.unlock();
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::forkChild()
+    {
+        _warmMtx.unlock();
+        _stacksMtx.unlock();
+        _warmBuilderMtx.unlock();
+
+        //построителя в потомке нет, его слоты освобождаются ниже вместе с прочими; pthread_* по нему звать нельзя
+        new(&_warmBuilder) std::thread{};
+
+        //стек, на котором шел fork, в потомке продолжает работать и дальше наследуется
+        if(StacksIds::_badId != _forkStack)
+        {
+            _inherited.push_back(_forkStack);
+            _forkStack = StacksIds::_badId;
+        }
+
+        /*
+         * в потомке живы только унаследованные стеки, содержимое остальных обнулено (или скопировано, если
+         * WIPEONFORK недоступен) и владеть ими некому - их идентификаторы освобождаются, слоты закрываются.
+         * объекты Stack родителя для таких стеков в потомке трогать нельзя
+         */
+        std::sort(_inherited.begin(), _inherited.end());
+
+        _warm.clear();
+        _warmAmount.store(0, std::memory_order_relaxed);
+
+        for(std::atomic<std::size_t>& counter : _peakPagesHistogram)
+        {
+            counter.store(0, std::memory_order_relaxed);
+        }
+        _allocatedStacks.store(_inherited.size(), std::memory_order_relaxed);
+
+        vm::Batch batch;
+        for(StacksIds::ConstIterator iter = _stacksIds.begin(); iter != _stacksIds.end();)
+        {
+            idAllocator::Id stackId = *iter;
+            ++iter;
+
+            stack::Content* stackContent = VirtualSpace::stackContent(stackId);
+
+            if(std::binary_search(_inherited.begin(), _inherited.end(), stackId))
+            {
+                _peakPagesHistogram[peakPages(stackContent)].fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            if(!batch.protect(stackContent, _stackSize, vm::Protection::none))
+            {
+                dbgWarn("unable to protect region");
+                std::abort();
+            }
+            _stacksIds.deallocate(stackId);
+        }
+
+        if(!batch.flush())
+        {
+            dbgWarn("unable to protect region");
+            std::abort();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::vector<std::size_t> VirtualSpace::peakPagesHistogram() const
+    {
+        std::vector<std::size_t> res(std::size(_peakPagesHistogram));
+        for(std::size_t idx{}; idx<res.size(); ++idx)
+        {
+            res[idx] = _peakPagesHistogram[idx].load(std::memory_order_relaxed);
+        }
+
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::census(mm::stats::Stacks& res) const
+    {
+        constexpr std::size_t buckets = mm::stats::Stacks::_occupancyBuckets;
+        constexpr std::size_t lineVolume = StacksIds::_lineVolume;
+
+        res._lineVolume = lineVolume;
+        res._reservedBytes = reservedBytes();
+
+        std::size_t usedLines{};
+
+        {
+            std::lock_guard lock{_stacksMtx};
+
+            res._allocated = _stacksIds.amount();
+            if(res._allocated)
+            {
+                res._span = _stacksIds.maxAllocated() + 1;
+            }
+
+            _stacksIds.forEachLine([&](idAllocator::Id, std::size_t allocated)
+            {
+                res._occupancy[std::min(allocated * buckets / lineVolume, buckets - 1)]++;
+                res._partialLines += allocated < lineVolume ? 1 : 0;
+                usedLines++;
+            });
+        }
+
+        res._holes = res._span - res._allocated;
+        res._externalFragmentation = res._span ? static_cast<double>(res._holes) / static_cast<double>(res._span) : 0;
+        res._spanBytes = res._span * _stackSize;
+
+        res._lines = utils::alignUp(res._span, lineVolume) / lineVolume;
+        res._emptyLines = res._lines - std::min<std::uint64_t>(usedLines, res._lines);
+        res._occupancy[0] += res._emptyLines;
+
+        std::lock_guard lock{_warmMtx};
+        for(stack::Content* stackContent : _warm)
+        {
+            res._warmCommittedBytes += stackContent->committedBytes();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t VirtualSpace::peakPages(stack::Content* stackContent)
+    {
+        return std::min(utils::alignUp(stackContent->peakBytes(), Config::_pageSize) / Config::_pageSize, Config::_stackPages);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::setLimit(std::size_t stacks)
+    {
+        _limit.store(std::min(stacks, Config::_stacksAmount), std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t VirtualSpace::limit() const
+    {
+        return _limit.load(std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t VirtualSpace::reservedBytes() const
+    {
+        const ChunksIndex* index = acquireIndex();
+        std::size_t res = index ? index->_amount * _chunkVmSize : 0;
+        releaseIndex();
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t VirtualSpace::allocatedStacks() const
+    {
+        return _allocatedStacks.load(std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    idAllocator::Id VirtualSpace::allocStackId(bool limited)
+    {
+        idAllocator::Id stackId = _stacksIds.allocate();
+        if(StacksIds::_badId == stackId)
+        {
+            return StacksIds::_badId;
+        }
+
+        //наименьший свободный: ниже него все заняты, стеки обработчиков SIGSEGV в предел не входят
+        if((limited && stackId >= _limit.load(std::memory_order_relaxed) + _altStacks.load(std::memory_order_relaxed)) ||
+           (stackId / _chunkStacks >= _chunks.size() && !reserveChunk()))
+        {
+            _stacksIds.deallocate(stackId);
+            return StacksIds::_badId;
+        }
+
+        return stackId;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    stack::Content* VirtualSpace::stackContent(idAllocator::Id stackId) const
+    {
+        std::uintptr_t begin = utils::alignUp(utils::sized_cast<std::uintptr_t>(_chunks[stackId / _chunkStacks]), _stackSize);
+        return utils::sized_cast<stack::Content *>(begin + stackId % _chunkStacks * _stackSize);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool VirtualSpace::locate(const void* addr, idAllocator::Id& stackId) const
+    {
+        const ChunksIndex* index = acquireIndex();
+        if(!index)
+        {
+            releaseIndex();
+            return false;
+        }
+
+        const char* ptr = static_cast<const char *>(addr);
+        const Chunk* end = index->_chunks + index->_amount;
+        const Chunk* chunk = std::upper_bound(index->_chunks, end, ptr, [](const char* p, const Chunk& c){return p < c._begin;});
+        if(chunk == index->_chunks)
+        {
+            releaseIndex();
+            return false;
+        }
+        --chunk;
+
+        std::size_t offset = static_cast<std::size_t>(ptr - chunk->_begin);
+        std::size_t number = chunk->_number;
+        releaseIndex();
+
+        if(offset >= _chunkSize)
+        {
+            return false;
+        }
+
+        stackId = number * _chunkStacks + offset / _stackSize;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    const VirtualSpace::ChunksIndex* VirtualSpace::acquireIndex() const
+    {
+        //seq_cst в паре с freeRetiredIndices: либо писатель видит читателя, либо читатель видит уже новый индекс
+        _indexReaders.fetch_add(1, std::memory_order_seq_cst);
+        return _chunksIndex.load(std::memory_order_seq_cst);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::releaseIndex() const
+    {
+        _indexReaders.fetch_sub(1, std::memory_order_release);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void VirtualSpace::freeRetiredIndices()
+    {
+        if(!_retiredIndices || _indexReaders.load(std::memory_order_seq_cst))
+        {
+            return;
+        }
+
+        while(_retiredIndices)
+        {
+            const ChunksIndex* index = _retiredIndices;
+            _retiredIndices = index->_retired;
+            system::free(const_cast<ChunksIndex*>(index));
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool VirtualSpace::reserveChunk()
+    {
+        void* area = vm::alloc(_chunkVmSize);
+        if(!area)
+        {
+            return false;
+        }
+
+        const ChunksIndex* old = _chunksIndex.load(std::memory_order_relaxed);
+        std::size_t amount = (old ? old->_amount : 0) + 1;
+
+        ChunksIndex* index = static_cast<ChunksIndex*>(system::malloc(sizeof(ChunksIndex) + (amount-1) * sizeof(Chunk)));
+        if(!index)
+        {
+            vm::free(area, _chunkVmSize);
+            return false;
+        }
+
+        Chunk chunk{utils::sized_cast<char *>(utils::alignUp(utils::sized_cast<std::uintptr_t>(area), _stackSize)), _chunks.size()};
+
+        //не удалось - стеки просто будут копироваться в потомка как раньше
+        if(Config::_stackForkWipe)
+        {
+            vm::forkExclude(area, _chunkVmSize);
+        }
+
+        const Chunk* oldBegin = old ? old->_chunks : nullptr;
+        const Chunk* oldEnd = old ? old->_chunks + old->_amount : nullptr;
+        const Chunk* pos = std::upper_bound(oldBegin, oldEnd, chunk, [](const Chunk& a, const Chunk& b){return a._begin < b._begin;});
+
+        Chunk* out = std::copy(oldBegin, pos, index->_chunks);
+        *out++ = chunk;
+        std::copy(pos, oldEnd, out);
+        index->_amount = amount;
+        index->_retired = nullptr;
+
+        _chunks.push_back(area);
+        _chunksIndex.store(index, std::memory_order_seq_cst);
+
+        //старый индекс может прямо сейчас читать обработчик SIGSEGV в другом потоке
+        if(old)
+        {
+            const_cast<ChunksIndex*>(old)->_retired = _retiredIndices;
+            _retiredIndices = old;
+        }
+        freeRetiredIndices();
+
+        return true;
+    }
 }
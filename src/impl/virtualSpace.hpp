@@ -7,11 +7,17 @@
 
 #pragma once
 #include "config.hpp"
-#include "bitIndex.hpp"
 #include "utils/align.hpp"
 
 #include "stack/content.hpp"
 
+#include <dci/mm/idAllocator.hpp>
+#include <dci/mm/stats.hpp>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 namespace dci::mm::impl
 {
 
@@ -20,36 +26,119 @@ namespace dci::mm::impl
     {
 
     public:
-        VirtualSpace();
+        explicit VirtualSpace(std::size_t limit = Config::_stacksAmount);
         ~VirtualSpace();
 
+        // основное пространство, ставит процессные обработчики SIGSEGV и fork
         static VirtualSpace& single();
 
     public:
-        stack::Content* allocStackContent();
+        stack::Content* allocStackContent(const mm::stack::Options& options);
+        stack::Content* tryAllocStackContent(const mm::stack::Options& options);
         void freeStackContent(stack::Content* stackContent);
+
+        // свой стек обработчика SIGSEGV текущему потоку, если еще нет, из основного пространства; освобождается при завершении потока
+        static bool prepareThread();
+
+        void warm(std::size_t count, std::size_t pagesEach);
+        std::size_t warmAmount() const;
+
+        // разобрать готовые стеки всех пространств, возвращает освобожденный объем
+        static std::size_t dropWarmAll();
+
+        void setLimit(std::size_t stacks);
+        std::size_t limit() const;
+        std::size_t reservedBytes() const;
+        std::size_t allocatedStacks() const;
         void setupPanicHandler(void(*)(int));
 
+        std::vector<std::size_t> peakPagesHistogram() const;
+        void census(mm::stats::Stacks& res) const;
+
         ////////////////////////////////////////////////////////////////
         bool vmAccessHandler(void* addr);
         void vmPanic(int signum);
 
+        void forkPrepare();
+        void forkParent();
+        void forkChild();
+
     private:
-        using StacksBitIndex = BitIndex<Config::_stacksAmount>;
+        struct AltStack;
+        static thread_local AltStack t_altStack;
+
+        static std::size_t peakPages(stack::Content* stackContent);
+        stack::Content* createStackContent(const mm::stack::Options& options, bool limited);
+        stack::Content* takeWarm(const mm::stack::Options& options);
+        std::size_t dropWarm();
+        void destroyStackContent(stack::Content* stackContent);
+
+    private:
+        using StacksIds = IdAllocator<Config::_stacksAmount, idAllocator::Storage::vm>;
 
-        static constexpr std::size_t _stacksBitIndexAlignedSize = utils::alignUp(sizeof(StacksBitIndex), Config::_pageSize);
-        static constexpr std::size_t _stacksPad = Config::_stackPages*Config::_pageSize;
         static constexpr std::size_t _stackSize = Config::_stackPages*Config::_pageSize;
-        static constexpr std::size_t _stacksAlignedSize = Config::_stacksAmount * _stackSize;
+        static constexpr std::size_t _chunkStacks = Config::_stacksChunkAmount;
+        static constexpr std::size_t _chunkSize = _chunkStacks * _stackSize;
+
+        //плюс стек на выравнивание начала куска
+        static constexpr std::size_t _chunkVmSize = _stackSize + _chunkSize;
+
+        idAllocator::Id allocStackId(bool limited = true);
+        stack::Content* stackContent(idAllocator::Id stackId) const;
+        bool locate(const void* addr, idAllocator::Id& stackId) const;
+        bool reserveChunk();
+
+    private:
+        /*
+         * адресное пространство под стеки резервируется кусками по мере роста идентификаторов,
+         * индекс кусков по адресу заменяется целиком - его без блокировок читает обработчик SIGSEGV
+         */
+        struct Chunk
+        {
+            char*       _begin;
+            std::size_t _number;
+        };
 
-        static constexpr std::size_t _vmSize =
-                _stacksBitIndexAlignedSize + _stacksPad + _stacksAlignedSize;
+        struct ChunksIndex
+        {
+            std::size_t         _amount;
+            const ChunksIndex*  _retired;//замененные, ждущие освобождения
+            Chunk               _chunks[1];
+        };
 
+        /*
+         * читатели индекса (в том числе обработчик SIGSEGV) отмечаются в _indexReaders,
+         * замененный индекс освобождается, только когда читателей нет
+         */
+        const ChunksIndex* acquireIndex() const;
+        void releaseIndex() const;
+        void freeRetiredIndices();
 
-        void* _vm;
+        //идентификаторы, куски и наследуемые: стеки сигнальных обработчиков приходят и уходят вместе с потоками
+        mutable std::mutex                  _stacksMtx;
+        StacksIds                           _stacksIds;
+        std::vector<void*>                  _chunks;//по номеру
+        std::atomic<const ChunksIndex*>     _chunksIndex {};
+        mutable std::atomic<std::size_t>    _indexReaders {};
+        const ChunksIndex*                  _retiredIndices {};
+        std::atomic<std::size_t>            _limit {Config::_stacksAmount};
+        std::atomic<std::size_t>            _allocatedStacks {};
+        std::atomic<std::size_t>            _altStacks {};//стеки обработчиков SIGSEGV, вне _limit и _allocatedStacks
 
-        StacksBitIndex* _stacksBitIndex;
-        void* _stacks;
         void(*_panic)(int){};
+
+        std::atomic<std::size_t> _peakPagesHistogram[Config::_stackPages+1] {};
+
+        //заранее построенные в фоне стеки, идентификаторы под них выделены сразу
+        mutable std::mutex              _warmMtx;
+        std::vector<stack::Content*>    _warm;
+        std::atomic<std::size_t>        _warmAmount {};
+        std::mutex                      _warmBuilderMtx;
+        std::thread                     _warmBuilder;
+        std::atomic<bool>               _warmStop {};
+
+        //стеки с Options::_inheritOnFork, только они остаются живыми в потомке fork
+        std::vector<idAllocator::Id>    _inherited;
+        idAllocator::Id                 _forkStack {StacksIds::_badId};//на нем выполняется fork, открыт потомку на время fork
     };
 }
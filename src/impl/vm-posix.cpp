@@ -6,12 +6,15 @@
    You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
 
 #include "vm.hpp"
+#include "config.hpp"
+#include "stats.hpp"
 
 #include <signal.h>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <sys/mman.h>
+#include <atomic>
 
 #include <iostream>
 
@@ -37,9 +40,6 @@ namespace dci::mm::impl::vm
             TVmAccessHandler        _accessHandler {};
             TVmPanic                _panic {};
 
-            static constexpr size_t _altStackSize {16 * 1024 * 1024};
-            char                    _altStackArea[_altStackSize] {};
-            ::stack_t               _oldAltStack {};
             struct ::sigaction      _oldAction {};
 
             void * operator new(size_t size)
@@ -57,6 +57,8 @@ namespace dci::mm::impl::vm
 
         State* g_state = nullptr;
 
+        std::atomic<std::size_t> g_decommittedBytes {};
+
         /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
         void segvHandler(int signal_number, siginfo_t* info, void* ctx)
         {
@@ -64,10 +66,15 @@ namespace dci::mm::impl::vm
 
             if(state)
             {
+                stats::Ticks start = stats::ticks();
                 if(state->_accessHandler(info->si_addr))
                 {
+                    stats::Ticks duration = stats::ticks() - start;
+                    stats::g_vm._handledFaults.add(duration);
+                    DCI_MM_PROBE2(fault, info->si_addr, duration);
                     return;
                 }
+                stats::g_vm._unhandledFaults.fetch_add(1, std::memory_order_relaxed);
 
                 char buf[64];
                 std::sprintf(buf, "%p", info->si_addr);
@@ -119,19 +126,6 @@ namespace dci::mm::impl::vm
         g_state->_accessHandler = accessHandler;
         g_state->_panic = panic;
 
-        ::stack_t altstack;
-        memset(&altstack, 0, sizeof(altstack));
-        altstack.ss_size = g_state->_altStackSize;
-        altstack.ss_sp = g_state->_altStackArea;
-        altstack.ss_flags = 0;
-        if(sigaltstack(&altstack, &g_state->_oldAltStack))
-        {
-            delete g_state;
-            g_state = nullptr;
-            perror("sigaltstack");
-            return false;
-        }
-
         struct ::sigaction sa;
         memset(&sa, 0, sizeof(sa));
         sa.sa_sigaction = &segvHandler;
@@ -170,11 +164,6 @@ namespace dci::mm::impl::vm
             perror("sigaction");
         }
 
-        if(sigaltstack(&g_state->_oldAltStack, nullptr))
-        {
-            perror("sigaltstack");
-        }
-
         delete g_state;
         g_state = nullptr;
         return true;
@@ -198,7 +187,7 @@ namespace dci::mm::impl::vm
         }
 
 
-        if(madvise(addr, size, MADV_DONTDUMP))
+        if(Config::_vmDumpControl && madvise(addr, size, MADV_DONTDUMP))
         {
             perror("madvise");
             munmap(addr, size);//ignore error
@@ -220,40 +209,230 @@ namespace dci::mm::impl::vm
         return true;
     }
 
-    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    bool protect(void* addr, std::size_t size, Protection protection)
+    namespace
     {
-        switch(protection)
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        bool protectImpl(void* addr, std::size_t size, Protection protection)
         {
-        case Protection::none:
-            if(mprotect(addr, size, PROT_NONE))
+            switch(protection)
             {
-                perror("mprotect");
-                return false;
-            }
+            case Protection::none:
+                if(mprotect(addr, size, PROT_NONE))
+                {
+                    perror("mprotect");
+                    return false;
+                }
 
-            if(madvise(addr, size, MADV_DONTDUMP))
-            {
-                perror("madvise");
-                return false;
-            }
-            break;
+                if(Config::_vmDumpControl && madvise(addr, size, MADV_DONTDUMP))
+                {
+                    perror("madvise");
+                    return false;
+                }
+                break;
 
-        case Protection::rw:
-            if(mprotect(addr, size, PROT_READ|PROT_WRITE))
-            {
-                perror("mprotect");
-                return false;
-            }
+            case Protection::rw:
+                if(mprotect(addr, size, PROT_READ|PROT_WRITE))
+                {
+                    perror("mprotect");
+                    return false;
+                }
 
-            if(madvise(addr, size, MADV_DODUMP))
-            {
-                perror("madvise");
-                return false;
+                if(Config::_vmDumpControl && madvise(addr, size, MADV_DODUMP))
+                {
+                    perror("madvise");
+                    return false;
+                }
+                break;
             }
+
+            return true;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool protect(void* addr, std::size_t size, Protection protection)
+    {
+        stats::Ticks start = stats::ticks();
+        bool res = protectImpl(addr, size, protection);
+        stats::Ticks duration = stats::ticks() - start;
+
+        stats::g_vm._protects.add(duration);
+        if(!res)
+        {
+            stats::g_vm._failedProtects.fetch_add(1, std::memory_order_relaxed);
+        }
+        DCI_MM_PROBE3(protect, addr, size, duration);
+
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool decommit(void* addr, std::size_t size, Decommit decommit)
+    {
+        int advice;
+        switch(decommit)
+        {
+        case Decommit::none:
+            return true;
+
+        case Decommit::free:
+#ifdef MADV_FREE
+            advice = MADV_FREE;
+            break;
+#endif
+        case Decommit::dontNeed:
+        default:
+            advice = MADV_DONTNEED;
             break;
         }
 
+        if(madvise(addr, size, advice))
+        {
+            perror("madvise");
+            return false;
+        }
+
+        g_decommittedBytes.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t decommittedBytes()
+    {
+        return g_decommittedBytes.load(std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool populate(void* addr, std::size_t size)
+    {
+#ifdef MADV_POPULATE_WRITE
+        if(!madvise(addr, size, MADV_POPULATE_WRITE))
+        {
+            return true;
+        }
+#endif
+        //ядро старое или не умеет - пройтись по страницам вручную
+        volatile char* begin = static_cast<volatile char *>(addr);
+        for(std::size_t offset{}; offset < size; offset += Config::_pageSize)
+        {
+            begin[offset] = begin[offset];
+        }
+
         return true;
     }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void* allocHuge(std::size_t size)
+    {
+#ifdef MAP_HUGETLB
+        void* addr = mmap(
+                            nullptr,
+                            size,
+                            PROT_READ|PROT_WRITE,
+                            MAP_ANONYMOUS|MAP_PRIVATE|MAP_HUGETLB,
+                            0,
+                            0);
+
+        if(MAP_FAILED != addr)
+        {
+            return addr;
+        }
+#else
+        (void)size;
+#endif
+        //пул пуст или не настроен, не ошибка - вызывающий перейдет на обычные страницы
+        return nullptr;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool adviseHuge(void* addr, std::size_t size)
+    {
+#ifdef MADV_HUGEPAGE
+        if(madvise(addr, size, MADV_HUGEPAGE))
+        {
+            perror("madvise");
+            return false;
+        }
+        return true;
+#else
+        (void)addr;
+        (void)size;
+        return false;
+#endif
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool forkExclude(void* addr, std::size_t size)
+    {
+#ifdef MADV_WIPEONFORK
+        if(madvise(addr, size, MADV_WIPEONFORK))
+        {
+            perror("madvise");
+            return false;
+        }
+        return true;
+#else
+        (void)addr;
+        (void)size;
+        return false;
+#endif
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool forkInclude(void* addr, std::size_t size)
+    {
+#ifdef MADV_KEEPONFORK
+        if(madvise(addr, size, MADV_KEEPONFORK))
+        {
+            perror("madvise");
+            return false;
+        }
+#else
+        (void)addr;
+        (void)size;
+#endif
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool altStackSet(void* addr, std::size_t size)
+    {
+        ::stack_t current;
+        if(sigaltstack(nullptr, &current))
+        {
+            perror("sigaltstack");
+            return false;
+        }
+
+        //поставленный кем-то другим не трогаем, обработчик отработает и на нем
+        if(!(current.ss_flags & SS_DISABLE))
+        {
+            return false;
+        }
+
+        ::stack_t altstack;
+        memset(&altstack, 0, sizeof(altstack));
+        altstack.ss_sp = addr;
+        altstack.ss_size = size;
+        altstack.ss_flags = 0;
+        if(sigaltstack(&altstack, nullptr))
+        {
+            perror("sigaltstack");
+            return false;
+        }
+
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void altStackReset()
+    {
+        ::stack_t altstack;
+        memset(&altstack, 0, sizeof(altstack));
+        altstack.ss_flags = SS_DISABLE;
+        if(sigaltstack(&altstack, nullptr))
+        {
+            perror("sigaltstack");
+        }
+    }
 }
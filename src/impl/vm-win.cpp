@@ -6,11 +6,14 @@
    You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
 
 #include "vm.hpp"
+#include "config.hpp"
+#include "stats.hpp"
 #include <dci/utils/dbg.hpp>
 #include <cstdio>
 #include <cstdlib>
 #include <csignal>
 #include <windows.h>
+#include <atomic>
 
 namespace dci::mm::impl::vm
 {
@@ -40,6 +43,8 @@ namespace dci::mm::impl::vm
 
         State* g_state = nullptr;
 
+        std::atomic<std::size_t> g_decommittedBytes {};
+
         /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
         LONG NTAPI vectoredExceptionHandler(struct _EXCEPTION_POINTERS *info)
         {
@@ -58,10 +63,13 @@ namespace dci::mm::impl::vm
 
             if(state)
             {
+                stats::Ticks start = stats::ticks();
                 if(state->_accessHandler(addr))
                 {
+                    stats::g_vm._handledFaults.add(stats::ticks() - start);
                     return EXCEPTION_CONTINUE_EXECUTION;
                 }
+                stats::g_vm._unhandledFaults.fetch_add(1, std::memory_order_relaxed);
 
                 std::fprintf(stderr, "unhandled AV for 0x%p, do panic\n", addr);
                 std::fflush(stderr);
@@ -162,30 +170,127 @@ namespace dci::mm::impl::vm
         return true;
     }
 
-    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
-    bool protect(void* addr, std::size_t size, Protection protection)
+    namespace
     {
-        switch(protection)
+        /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+        bool protectImpl(void* addr, std::size_t size, Protection protection)
         {
-        case Protection::none:
-            if(!VirtualFree(addr, size, MEM_DECOMMIT))
+            switch(protection)
             {
-                std::fprintf(stderr, "vm::protect: VirtualFree failed: %lu\n", GetLastError());
-                std::fflush(stderr);
-                return false;
-            }
-            break;
+            case Protection::none:
+                if(!VirtualFree(addr, size, MEM_DECOMMIT))
+                {
+                    std::fprintf(stderr, "vm::protect: VirtualFree failed: %lu\n", GetLastError());
+                    std::fflush(stderr);
+                    return false;
+                }
+                break;
 
-        case Protection::guard:
-        case Protection::rw:
-            if(addr != VirtualAlloc(addr, size, MEM_COMMIT, PAGE_READWRITE | (Protection::guard == protection ? PAGE_GUARD : 0)))
-            {
-                std::fprintf(stderr, "vm::protect: VirtualAlloc failed: %lu\n", GetLastError());
-                std::fflush(stderr);
-                return false;
+            case Protection::guard:
+            case Protection::rw:
+                if(addr != VirtualAlloc(addr, size, MEM_COMMIT, PAGE_READWRITE | (Protection::guard == protection ? PAGE_GUARD : 0)))
+                {
+                    std::fprintf(stderr, "vm::protect: VirtualAlloc failed: %lu\n", GetLastError());
+                    std::fflush(stderr);
+                    return false;
+                }
             }
+
+            return true;
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool protect(void* addr, std::size_t size, Protection protection)
+    {
+        stats::Ticks start = stats::ticks();
+        bool res = protectImpl(addr, size, protection);
+
+        stats::g_vm._protects.add(stats::ticks() - start);
+        if(!res)
+        {
+            stats::g_vm._failedProtects.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        return res;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool decommit(void* addr, std::size_t size, Decommit decommit)
+    {
+        if(Decommit::none == decommit)
+        {
+            return true;
+        }
+
+        if(!VirtualFree(addr, size, MEM_DECOMMIT))
+        {
+            std::fprintf(stderr, "vm::decommit: VirtualFree failed: %lu\n", GetLastError());
+            std::fflush(stderr);
+            return false;
+        }
+
+        g_decommittedBytes.fetch_add(size, std::memory_order_relaxed);
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    std::size_t decommittedBytes()
+    {
+        return g_decommittedBytes.load(std::memory_order_relaxed);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool populate(void* addr, std::size_t size)
+    {
+        volatile char* begin = static_cast<volatile char *>(addr);
+        for(std::size_t offset{}; offset < size; offset += Config::_pageSize)
+        {
+            begin[offset] = begin[offset];
         }
 
         return true;
     }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    void* allocHuge(std::size_t size)
+    {
+        //требует SeLockMemoryPrivilege, без него просто отказ
+        if(!GetLargePageMinimum())
+        {
+            return nullptr;
+        }
+
+        return VirtualAlloc(
+                            nullptr,
+                            size,
+                            MEM_RESERVE|MEM_COMMIT|MEM_LARGE_PAGES,
+                            PAGE_READWRITE);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool adviseHuge(void* addr, std::size_t size)
+    {
+        //прозрачных крупных страниц нет
+        (void)addr;
+        (void)size;
+        return false;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool forkExclude(void* addr, std::size_t size)
+    {
+        //fork нет
+        (void)addr;
+        (void)size;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool forkInclude(void* addr, std::size_t size)
+    {
+        (void)addr;
+        (void)size;
+        return true;
+    }
 }
@@ -0,0 +1,114 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include "vm.hpp"
+#include <dci/utils/dbg.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace dci::mm::impl::vm
+{
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    Batch::~Batch()
+    {
+        if(!flush())
+        {
+            dbgWarn("unable to protect region");
+            std::abort();
+        }
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool Batch::protect(void* addr, std::size_t size, Protection protection)
+    {
+        char* begin = static_cast<char *>(addr);
+        return push(Range{begin, begin + size, false, protection, Decommit::none});
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool Batch::decommit(void* addr, std::size_t size, Decommit decommit)
+    {
+        if(Decommit::none == decommit)
+        {
+            return true;
+        }
+
+        char* begin = static_cast<char *>(addr);
+        return push(Range{begin, begin + size, true, Protection::none, decommit});
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool Batch::Range::sameOperation(const Range& other) const
+    {
+        return _decommit == other._decommit && (_decommit ? _decommitMode == other._decommitMode : _protection == other._protection);
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool Batch::push(const Range& newRange)
+    {
+        if(newRange._begin == newRange._end)
+        {
+            return true;
+        }
+
+        /*
+         * flush применяет диапазоны в порядке очереди. новый встает за последним пересекающимся с другой операцией:
+         * сливается только с теми, что после него, иначе добавляется в конец - порядок сохраняется без сброса
+         */
+        std::size_t mergeFrom{};
+        for(std::size_t idx{}; idx<_rangesAmount; ++idx)
+        {
+            const Range& range = _ranges[idx];
+
+            if(!range.sameOperation(newRange) && newRange._begin < range._end && newRange._end > range._begin)
+            {
+                mergeFrom = idx + 1;
+            }
+        }
+
+        for(std::size_t idx{mergeFrom}; idx<_rangesAmount; ++idx)
+        {
+            Range& range = _ranges[idx];
+
+            if(range.sameOperation(newRange) && newRange._begin <= range._end && newRange._end >= range._begin)
+            {
+                range._begin = std::min(range._begin, newRange._begin);
+                range._end = std::max(range._end, newRange._end);
+                return true;
+            }
+        }
+
+        if(_rangesAmount == _rangesCapacity)
+        {
+            if(!flush())
+            {
+                return false;
+            }
+        }
+
+        _ranges[_rangesAmount++] = newRange;
+        return true;
+    }
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    bool Batch::flush()
+    {
+        bool res = true;
+        for(std::size_t idx{}; idx<_rangesAmount; ++idx)
+        {
+            const Range& range = _ranges[idx];
+            std::size_t size = static_cast<std::size_t>(range._end - range._begin);
+            res &= range._decommit ?
+                       vm::decommit(range._begin, size, range._decommitMode) :
+                       vm::protect(range._begin, size, range._protection);
+        }
+        _rangesAmount = 0;
+
+        return res;
+    }
+}
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "config.hpp"
+
 #include <cstddef>
 
 namespace dci::mm::impl::vm
@@ -30,4 +32,62 @@ namespace dci::mm::impl::vm
     };
 
     bool protect(void* addr, std::size_t size, Protection protection);
+
+    bool decommit(void* addr, std::size_t size, Decommit decommit);
+    std::size_t decommittedBytes();
+
+    bool populate(void* addr, std::size_t size);
+
+    // содержимое не копируется в потомка fork (там область обнулена) / обычное наследование
+    bool forkExclude(void* addr, std::size_t size);
+    bool forkInclude(void* addr, std::size_t size);
+
+#ifndef _WIN32
+    // стек обработчика SIGSEGV текущего потока; false - у потока уже есть свой или не удалось
+    bool altStackSet(void* addr, std::size_t size);
+    void altStackReset();
+#endif
+
+    // область из пула крупных страниц (hugetlbfs, large pages), сразу rw; nullptr если пул не настроен
+    void* allocHuge(std::size_t size);
+
+    // прозрачные крупные страницы для уже открытой области
+    bool adviseHuge(void* addr, std::size_t size);
+
+    /////////0/////////1/////////2/////////3/////////4/////////5/////////6/////////7
+    /*
+     * накопитель изменений защиты и освобождений, смежные диапазоны с одинаковой
+     * операцией склеиваются и применяются одним вызовом при flush
+     */
+    class Batch
+    {
+    public:
+        Batch() = default;
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+        ~Batch();
+
+        bool protect(void* addr, std::size_t size, Protection protection);
+        bool decommit(void* addr, std::size_t size, Decommit decommit);
+        bool flush();
+
+    private:
+        struct Range
+        {
+            char*       _begin;
+            char*       _end;
+            bool        _decommit;
+            Protection  _protection;
+            Decommit    _decommitMode;
+
+            bool sameOperation(const Range& other) const;
+        };
+
+        bool push(const Range& range);
+
+        static constexpr std::size_t _rangesCapacity = 4;
+
+        Range       _ranges[_rangesCapacity];
+        std::size_t _rangesAmount {};
+    };
 }
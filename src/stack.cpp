@@ -6,7 +6,10 @@
    You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
 
 #include <dci/mm/stack.hpp>
+#include <dci/mm/stackSpace.hpp>
 #include "impl/stack.hpp"
+#include "impl/vm.hpp"
+#include "impl/virtualSpace.hpp"
 
 namespace dci::mm
 {
@@ -31,9 +34,24 @@ namespace dci::mm
         return *this;
     }
 
-    void Stack::initialize()
+    void Stack::initialize(const stack::Options& options)
     {
-        return impl().initialize();
+        return impl().initialize(options);
+    }
+
+    void Stack::initialize(StackSpace& space, const stack::Options& options)
+    {
+        return impl().initialize(space.impl(), options);
+    }
+
+    bool Stack::tryInitialize(const stack::Options& options)
+    {
+        return impl().tryInitialize(impl::VirtualSpace::single(), options);
+    }
+
+    bool Stack::tryInitialize(StackSpace& space, const stack::Options& options)
+    {
+        return impl().tryInitialize(space.impl(), options);
     }
 
     bool Stack::initialized() const
@@ -66,9 +84,92 @@ namespace dci::mm
         return impl().size();
     }
 
+    std::size_t Stack::committedBytes() const
+    {
+        return impl().committedBytes();
+    }
+
+    std::size_t Stack::peakUsage() const
+    {
+        return impl().peakUsage();
+    }
+
     void Stack::compact()
     {
         return impl().compact();
     }
 
+    void Stack::compact(void* suspendedSp)
+    {
+        return impl().compact(suspendedSp);
+    }
+
+    bool Stack::hibernate()
+    {
+        return impl().hibernate();
+    }
+
+    void Stack::wake()
+    {
+        return impl().wake();
+    }
+
+    bool Stack::hibernated() const
+    {
+        return impl().hibernated();
+    }
+
+    std::size_t Stack::hibernatedBytes() const
+    {
+        return impl().hibernatedBytes();
+    }
+
+}
+
+namespace dci::mm::stack
+{
+    std::size_t decommittedBytes()
+    {
+        return impl::vm::decommittedBytes();
+    }
+
+    std::vector<std::size_t> peakPagesHistogram()
+    {
+        return impl::VirtualSpace::single().peakPagesHistogram();
+    }
+
+    void warm(std::size_t count, std::size_t pagesEach)
+    {
+        return impl::VirtualSpace::single().warm(count, pagesEach);
+    }
+
+    std::size_t warmAmount()
+    {
+        return impl::VirtualSpace::single().warmAmount();
+    }
+
+    void setLimit(std::size_t stacks)
+    {
+        return impl::VirtualSpace::single().setLimit(stacks);
+    }
+
+    std::size_t limit()
+    {
+        return impl::VirtualSpace::single().limit();
+    }
+
+    std::size_t reservedBytes()
+    {
+        return impl::VirtualSpace::single().reservedBytes();
+    }
+
+    std::size_t allocatedStacks()
+    {
+        return impl::VirtualSpace::single().allocatedStacks();
+    }
+
+    bool prepareThread()
+    {
+        return impl::VirtualSpace::single().prepareThread();
+    }
 }
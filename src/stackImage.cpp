@@ -0,0 +1,112 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/mm/stack/image.hpp>
+#include <dci/mm/stack.hpp>
+#include <dci/mm/heap/allocable.hpp>
+#include <dci/utils/dbg.hpp>
+
+#include <cstring>
+#include <utility>
+
+namespace dci::mm::stack
+{
+    ////////////////////////////////////////////////////////////////
+    Image::Image(Image&& from)
+        : _data{std::exchange(from._data, nullptr)}
+        , _size{std::exchange(from._size, 0)}
+    {
+    }
+
+    Image::~Image()
+    {
+        clear();
+    }
+
+    Image& Image::operator=(Image&& from)
+    {
+        if(this != &from)
+        {
+            clear();
+            _data = std::exchange(from._data, nullptr);
+            _size = std::exchange(from._size, 0);
+        }
+        return *this;
+    }
+
+    bool Image::save(const Stack& stack, const void* sp)
+    {
+        const char* bound = static_cast<const char *>(sp);
+        dbgAssert(bound >= stack.begin() && bound <= stack.end());
+
+        const char* begin = stack.growsDown() ? bound : stack.begin();
+        std::size_t size = static_cast<std::size_t>(stack.growsDown() ? stack.end() - bound : bound - stack.begin());
+
+        if(size != _size)
+        {
+            clear();
+            if(size)
+            {
+                _data = static_cast<char *>(heap::details::allocable::alloc(size));
+                if(!_data)
+                {
+                    return false;
+                }
+                _size = size;
+            }
+        }
+
+        if(size)
+        {
+            std::memcpy(_data, begin, size);
+        }
+        return true;
+    }
+
+    bool Image::save(const Stack& stack)
+    {
+        //committedBytes спящего не включает сжатое, а чтение его все равно развернет - содержимое стека не меняется
+        if(stack.hibernated())
+        {
+            const_cast<Stack&>(stack).wake();
+        }
+
+        return save(stack, stack.growsDown() ? stack.end() - stack.committedBytes() : stack.begin() + stack.committedBytes());
+    }
+
+    void Image::restore(const Stack& stack) const
+    {
+        dbgAssert(_size <= stack.size());
+
+        //недостающие страницы откроются обработчиком обращений
+        char* begin = stack.growsDown() ? stack.end() - _size : stack.begin();
+        if(_size)
+        {
+            std::memcpy(begin, _data, _size);
+        }
+    }
+
+    bool Image::empty() const
+    {
+        return !_size;
+    }
+
+    std::size_t Image::size() const
+    {
+        return _size;
+    }
+
+    void Image::clear()
+    {
+        if(_data)
+        {
+            heap::details::allocable::free(_data, _size);
+            _data = nullptr;
+            _size = 0;
+        }
+    }
+}
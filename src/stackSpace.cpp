@@ -0,0 +1,69 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/mm/stackSpace.hpp>
+#include "impl/virtualSpace.hpp"
+
+namespace dci::mm
+{
+    ////////////////////////////////////////////////////////////////
+    StackSpace::StackSpace()
+        : Base()
+    {
+    }
+
+    StackSpace::StackSpace(std::size_t limit)
+        : Base(limit)
+    {
+    }
+
+    StackSpace::~StackSpace()
+    {
+    }
+
+    void StackSpace::setLimit(std::size_t stacks)
+    {
+        return impl().setLimit(stacks);
+    }
+
+    std::size_t StackSpace::limit() const
+    {
+        return impl().limit();
+    }
+
+    std::size_t StackSpace::reservedBytes() const
+    {
+        return impl().reservedBytes();
+    }
+
+    std::size_t StackSpace::allocatedStacks() const
+    {
+        return impl().allocatedStacks();
+    }
+
+    std::vector<std::size_t> StackSpace::peakPagesHistogram() const
+    {
+        return impl().peakPagesHistogram();
+    }
+
+    stats::Stacks StackSpace::occupancy() const
+    {
+        stats::Stacks res;
+        impl().census(res);
+        return res;
+    }
+
+    void StackSpace::warm(std::size_t count, std::size_t pagesEach)
+    {
+        return impl().warm(count, pagesEach);
+    }
+
+    std::size_t StackSpace::warmAmount() const
+    {
+        return impl().warmAmount();
+    }
+}
@@ -0,0 +1,67 @@
+/* This file is part of the the dci project. Copyright (C) 2013-2023 vopl, shtoba.
+   This program is free software: you can redistribute it and/or modify it under the terms of the GNU Affero General Public
+   License as published by the Free Software Foundation, either version 3 of the License, or (at your option) any later version.
+   This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty
+   of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU Affero General Public License for more details.
+   You should have received a copy of the GNU Affero General Public License along with this program. If not, see <https://www.gnu.org/licenses/>. */
+
+#include <dci/mm/stats.hpp>
+#include "impl/stats.hpp"
+#include "impl/heap/arena.hpp"
+#include "impl/virtualSpace.hpp"
+
+#include <chrono>
+
+namespace dci::mm::stats
+{
+    Vm vm()
+    {
+        const impl::stats::Vm& src = impl::stats::g_vm;
+
+        Vm res;
+        src._handledFaults.read(res._handledFaults);
+        res._unhandledFaults = src._unhandledFaults.load(std::memory_order_relaxed);
+        src._protects.read(res._protects);
+        res._failedProtects = src._failedProtects.load(std::memory_order_relaxed);
+
+        return res;
+    }
+
+    Heap heap()
+    {
+        Heap res;
+        impl::heap::arena::census(res);
+        return res;
+    }
+
+    Stacks stacks()
+    {
+        Stacks res;
+        impl::VirtualSpace::single().census(res);
+        return res;
+    }
+
+    double ticksPerSecond()
+    {
+        static const double res = []
+        {
+            using Clock = std::chrono::steady_clock;
+
+            Clock::time_point start = Clock::now();
+            impl::stats::Ticks startTicks = impl::stats::ticks();
+
+            Clock::time_point stop;
+            do
+            {
+                stop = Clock::now();
+            }
+            while(stop - start < std::chrono::milliseconds{5});
+
+            impl::stats::Ticks stopTicks = impl::stats::ticks();
+
+            return static_cast<double>(stopTicks - startTicks) / std::chrono::duration<double>(stop - start).count();
+        }();
+
+        return res;
+    }
+}